@@ -0,0 +1,285 @@
+/* 模拟器性能测试.
+   用法: _bench -t <测试名> [-r <重复次数>]
+   row: 25 个机枪射手对 50 个僵尸 (每行 10 个), 测试每秒模拟帧数.
+   reset: 场上有少量植物与僵尸时, 测试每秒 scene::reset 次数 (应与对象池容量无关).
+   pogo: 跳跳测试的场景 (2 路 1000 个跳跳, 撑杆/叶子保护), 测试每秒模拟帧数.
+   snapshot: row 测试的场景运行 100 帧后保存, 测试每秒 world::snapshot + world::restore 次数.
+   spawn: 测试每秒 spawn::reset 次数 (出怪列表推迟到首次读取时才生成).
+   ob: 1000 个泳池场景 (每个有植物与已出的僵尸), 测试每秒生成的观测数 (observation_factory 批量 create).
+   setup: 炸率测试的两波操作 (炮, 卡片, 垫材, 智能垫材, 铲除), 测试每秒完成的单次重复准备次数 (各波 load_wave, 不运行场景).
+ */
+
+#include "common/pe.h"
+#include "common/test.h"
+#include "learning/observation_factory.h"
+#include "seml/explode/lib.h"
+#include "world.h"
+
+#include <chrono>
+#include <functional>
+#include <map>
+
+using namespace pvz_emulator;
+using namespace pvz_emulator::object;
+
+const int PROTECTED_HP = 100000000;
+
+// ticks per second
+double bench_row(int repeat)
+{
+    const int TICKS = 3000;
+    world w(scene_type::day);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeat; r++) {
+        w.scene.reset();
+        w.scene.stop_spawn = true;
+        w.scene.ignore_game_over = true;
+        w.scene.lock_dx = true;
+        w.scene.lock_dx_val = 0.05f;
+
+        for (unsigned int row = 0; row < 5; row++) {
+            for (unsigned int col = 0; col < 5; col++) {
+                w.plant_factory.create(plant_type::gatling_pea, row, col);
+            }
+            for (int i = 0; i < 10; i++) {
+                auto& z = w.zombie_factory.create(zombie_type::buckethead, static_cast<int>(row));
+                z.x = static_cast<float>(500 + 30 * i);
+                z.hp = PROTECTED_HP;
+                w.scene.update_wave_hp(z);
+            }
+        }
+
+        run(w, TICKS);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    return TICKS * repeat / elapsed.count();
+}
+
+// ticks per second
+double bench_pogo(int repeat)
+{
+    const int TICKS = 1000;
+    world w(scene_type::day);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeat; r++) {
+        w.scene.reset();
+        w.scene.stop_spawn = true;
+
+        w.plant_factory.create(plant_type::umbrella_leaf, 1, 6);
+        w.plant_factory.create(plant_type::cob_cannon, 1, 3);
+        for (int i = 0; i < 1000; i++) {
+            w.zombie_factory.create(zombie_type::pogo, 1);
+        }
+
+        run(w, TICKS);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    return TICKS * repeat / elapsed.count();
+}
+
+// resets per second
+double bench_reset(int repeat)
+{
+    const int RESETS = 10000;
+    world w(scene_type::day);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeat * RESETS; r++) {
+        w.scene.reset();
+
+        for (unsigned int row = 0; row < 5; row++) {
+            w.plant_factory.create(plant_type::wallnut, row, 0);
+            w.zombie_factory.create(zombie_type::zombie, static_cast<int>(row));
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    return RESETS * repeat / elapsed.count();
+}
+
+// snapshot + restore pairs per second
+double bench_snapshot(int repeat)
+{
+    const int ROUNDS = 10000;
+    world w(scene_type::day);
+    w.scene.stop_spawn = true;
+
+    for (unsigned int row = 0; row < 5; row++) {
+        for (unsigned int col = 0; col < 5; col++) {
+            w.plant_factory.create(plant_type::gatling_pea, row, col);
+        }
+        for (int i = 0; i < 10; i++) {
+            auto& z = w.zombie_factory.create(zombie_type::buckethead, static_cast<int>(row));
+            z.x = static_cast<float>(500 + 30 * i);
+        }
+    }
+    run(w, 100);
+
+    world::snapshot_data s;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeat * ROUNDS; r++) {
+        w.snapshot(s);
+        w.restore(s);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    return ROUNDS * repeat / elapsed.count();
+}
+
+// spawn list generations per second
+double bench_spawn(int repeat)
+{
+    const int RESETS = 10000;
+    world w(scene_type::pool);
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeat * RESETS; r++) {
+        w.spawn.reset();
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    return RESETS * repeat / elapsed.count();
+}
+
+Config make_setup_config()
+{
+    Config config;
+    config.setting.scene_type = config.setting.original_scene_type = scene_type::pool;
+    config.setting.protect_positions = {{Setting::ProtectPos::Type::Cob, 1, 8},
+        {Setting::ProtectPos::Type::Normal, 2, 8}, {Setting::ProtectPos::Type::Cob, 5, 8},
+        {Setting::ProtectPos::Type::Normal, 6, 8}};
+
+    auto cob = [](int time, float col) {
+        auto a = std::make_shared<Cob>();
+        a->symbol = "PP";
+        a->time = time;
+        a->positions = {{2, col}, {5, col}};
+        return a;
+    };
+
+    auto fixed_fodder = std::make_shared<FixedFodder>();
+    fixed_fodder->symbol = "C";
+    fixed_fodder->time = 150;
+    fixed_fodder->shovel_time = 300;
+    fixed_fodder->fodders = {Fodder::Normal, Fodder::Puff};
+    fixed_fodder->positions = {{1, 9}, {6, 9}};
+
+    auto smart_fodder = std::make_shared<SmartFodder>();
+    smart_fodder->symbol = "C_POS";
+    smart_fodder->time = 300;
+    smart_fodder->shovel_time = 500;
+    smart_fodder->fodders = {Fodder::Normal, Fodder::Pot, Fodder::Normal};
+    smart_fodder->positions = {{1, 9}, {2, 9}, {6, 9}};
+    smart_fodder->choose = 2;
+    smart_fodder->waves = {2};
+
+    auto fixed_card = std::make_shared<FixedCard>();
+    fixed_card->symbol = "J";
+    fixed_card->time = 800;
+    fixed_card->shovel_time = 900;
+    fixed_card->plant_type = plant_type::jalapeno;
+    fixed_card->position = {2, 9};
+
+    Wave wave1;
+    wave1.wave_length = wave1.start_tick = 601;
+    wave1.actions = {cob(318, 9.0f), fixed_fodder};
+
+    Wave wave2;
+    wave2.wave_length = wave2.start_tick = 1200;
+    wave2.ice_times = {1};
+    wave2.actions = {smart_fodder, fixed_card, cob(1100, 8.5f)};
+
+    config.waves = {wave1, wave2};
+    return config;
+}
+
+// repeats per second
+double bench_setup(int repeat)
+{
+    const int ROUNDS = 10000;
+
+    auto config = make_setup_config();
+    std::vector<Program> programs;
+    for (const auto& wave : config.waves) {
+        programs.push_back(compile_wave(config.setting, wave));
+    }
+    std::vector<Test> tests(programs.size());
+
+    // reads each prepared test, so that the loop is not optimized away
+    [[maybe_unused]] volatile size_t sink;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeat * ROUNDS; r++) {
+        for (size_t i = 0; i < programs.size(); i++) {
+            load_wave(programs[i], tests[i]);
+            sink = tests[i].protect_plants.capacity() + tests[i].plants_to_be_shoveled.size();
+        }
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    return repeat * ROUNDS / elapsed.count();
+}
+
+// observations per second
+double bench_ob(int repeat)
+{
+    const int WORLDS = 1000;
+    const int ROUNDS = 10;
+
+    std::vector<world> worlds;
+    worlds.reserve(WORLDS);
+    std::vector<world*> ptrs;
+    for (int i = 0; i < WORLDS; i++) {
+        auto& w = worlds.emplace_back(scene_type::pool, derive_seed(0, static_cast<uint64_t>(i)));
+        for (unsigned int row : {0u, 1u, 4u, 5u}) {
+            for (unsigned int col = 0; col < 4; col++) {
+                w.plant_factory.create(plant_type::gatling_pea, row, col);
+            }
+        }
+        run(w, 2000);
+        ptrs.push_back(&w);
+    }
+
+    learning::observation_factory factory(scene_type::pool, 100, 54, 100, 10);
+    world::batch_action_masks masks(WORLDS, world::action_masks(1, 1));
+    std::vector<float> ob;
+
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int r = 0; r < repeat * ROUNDS; r++) {
+        factory.create(ptrs, masks, ob);
+    }
+    std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
+
+    return WORLDS * ROUNDS * repeat / elapsed.count();
+}
+
+int main(int argc, char* argv[])
+{
+    std::vector<std::string> args(argv, argv + argc);
+    auto name = get_cmd_arg(args, "t");
+    auto repeat = std::stoi(get_cmd_arg(args, "r", "10"));
+
+    const std::map<std::string, std::pair<std::function<double(int)>, std::string>> benches = {
+        {"row", {bench_row, "帧/秒"}},
+        {"pogo", {bench_pogo, "帧/秒"}},
+        {"reset", {bench_reset, "次/秒"}},
+        {"snapshot", {bench_snapshot, "次/秒"}},
+        {"spawn", {bench_spawn, "次/秒"}},
+        {"ob", {bench_ob, "个/秒"}},
+        {"setup", {bench_setup, "次/秒"}},
+    };
+
+    auto it = benches.find(name);
+    if (it == benches.end()) {
+        std::cerr << "未知测试: " << name << std::endl;
+        return 1;
+    }
+
+    std::cout << name << ": " << std::fixed << std::setprecision(1) << it->second.first(repeat)
+              << " " << it->second.second << std::endl;
+
+    return 0;
+}
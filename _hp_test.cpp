@@ -1,12 +1,12 @@
 /* 获得每波僵尸血量.
  */
 
+#include "common/runner.h"
 #include "common/test.h"
 #include "seml/refresh/lib.h"
 #include "world.h"
 
 #include <map>
-#include <mutex>
 
 using namespace pvz_emulator;
 using namespace pvz_emulator::object;
@@ -21,49 +21,44 @@ ZombieTypes parse_zombie_types(const std::string& zombie_nums)
     return zombie_types;
 }
 
-std::mutex mtx;
 std::vector<std::vector<int>> results; // 3, 6, 12, 15
 std::map<int, int> wave_to_idx = {{3, 0}, {6, 1}, {12, 2}, {15, 3}};
 
-void test_one(const Config& config, int repeat, const ZombieTypes& required_types,
-    const ZombieTypes& banned_types)
+struct State {
+    world w;
+    std::vector<std::vector<int>> results;
+};
+
+void test_one(const Config& config, State& state, int round, uint64_t seed,
+    const ZombieTypes& required_types, const ZombieTypes& banned_types)
 {
-    std::mt19937 rng(
-        static_cast<unsigned int>(std::chrono::steady_clock::now().time_since_epoch().count()));
-    world w(config.setting.scene_type);
-    std::vector<std::vector<int>> local_results;
-    local_results.resize(wave_to_idx.size());
-
-    for (int round_idx = 0; round_idx < repeat; round_idx++) {
-        auto spawn_types = get_spawn_types(
-            rng, config.setting.original_scene_type, required_types, banned_types);
-        int giga_limit = 50;
-        for (int i = 1; i <= 15; i++) {
-            auto spawn_list = get_spawn_list(rng, spawn_types, false, true, giga_limit);
-            for (const auto& s : spawn_list) {
-                if (s == zombie_type::giga_gargantuar) {
-                    giga_limit--;
-                }
-            }
-            if (wave_to_idx.find(i) != wave_to_idx.end()) {
-                w.scene.spawn.wave = 0;
-                for (const auto& type : spawn_list) {
-                    w.zombie_factory.create(type);
-                }
-                w.scene.spawn.wave++; // required for get_current_hp() to work correctly
-                auto init_hp = static_cast<int>(w.spawn.get_current_hp());
-                local_results[wave_to_idx[i]].push_back(init_hp);
-
-                w.scene.reset();
-                w.scene.stop_spawn = true;
+    auto& w = state.w;
+
+    w.scene.reset(derive_seed(seed, round));
+    w.scene.stop_spawn = true;
+    std::mt19937 rng(w.scene.rng());
+
+    auto spawn_types
+        = get_spawn_types(rng, config.setting.original_scene_type, required_types, banned_types);
+    int giga_limit = 50;
+    for (int i = 1; i <= 15; i++) {
+        auto spawn_list = get_spawn_list(rng, spawn_types, false, true, giga_limit);
+        for (const auto& s : spawn_list) {
+            if (s == zombie_type::giga_gargantuar) {
+                giga_limit--;
             }
         }
-    }
+        if (wave_to_idx.find(i) != wave_to_idx.end()) {
+            w.scene.spawn.wave = 0;
+            for (const auto& type : spawn_list) {
+                w.zombie_factory.create(type);
+            }
+            w.scene.spawn.wave++; // required for get_current_hp() to work correctly
+            auto init_hp = static_cast<int>(w.spawn.get_current_hp());
+            state.results[wave_to_idx.at(i)].push_back(init_hp);
 
-    std::lock_guard<std::mutex> guard(mtx);
-    for (size_t i = 0; i < wave_to_idx.size(); i++) {
-        for (const auto& l : local_results[i]) {
-            results[i].push_back(l);
+            w.scene.reset();
+            w.scene.stop_spawn = true;
         }
     }
 }
@@ -79,6 +74,7 @@ int main(int argc, char* argv[])
     auto config_file = get_cmd_arg(args, "f");
     auto output_file = get_cmd_arg(args, "o", "hp_test");
     auto total_repeat_num = std::stoi(get_cmd_arg(args, "r", "1000"));
+    auto seed = get_seed(args);
     auto required_types = parse_zombie_types(get_cmd_arg(args, "req", ""));
     auto banned_types = parse_zombie_types(get_cmd_arg(args, "ban", ""));
 
@@ -86,15 +82,19 @@ int main(int argc, char* argv[])
 
     auto config = read_json(config_file);
 
-    std::vector<std::thread> threads;
-    for (int repeat : assign_repeat(total_repeat_num, std::thread::hardware_concurrency())) {
-        threads.emplace_back([config, repeat, required_types, banned_types]() {
-            test_one(config, repeat, required_types, banned_types);
-        });
-    }
-    for (auto& t : threads) {
-        t.join();
-    }
+    // the lists are sorted before output, so merging in any order is fine
+    results = run_repeats(
+        total_repeat_num,
+        [&]() { return State {world(config.setting.scene_type), results}; },
+        [&](State& state, int round) {
+            test_one(config, state, round, seed, required_types, banned_types);
+        },
+        [](State& into, State& from) {
+            for (size_t i = 0; i < into.results.size(); i++) {
+                into.results[i].insert(
+                    into.results[i].end(), from.results[i].begin(), from.results[i].end());
+            }
+        })->results;
 
     file << "测试环境: " << scene_type_to_str(config.setting.original_scene_type) << " ";
     file << "\n";
@@ -112,7 +112,7 @@ int main(int argc, char* argv[])
     std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
     std::cout << "输出文件已保存至 " << full_output_file << ".\n"
               << "耗时 " << std::fixed << std::setprecision(2) << elapsed.count() << " 秒, 使用了 "
-              << threads.size() << " 个线程." << std::endl;
+              << get_thread_num(total_repeat_num) << " 个线程, 随机种子 " << seed << "." << std::endl;
 
     return 0;
 }
\ No newline at end of file
@@ -3,11 +3,11 @@
  */
 
 #include "common/pe.h"
+#include "common/runner.h"
 #include "common/test.h"
 #include "world.h"
 
 #include <algorithm>
-#include <mutex>
 
 using namespace pvz_emulator;
 using namespace pvz_emulator::object;
@@ -22,6 +22,7 @@ const zombie_dance_cheat dance_cheat = zombie_dance_cheat::none;
 const bool OUTPUT_AS_INT
     = true; // if true, output float * 32768, which is guaranteed to be an integer when >= 256
 const bool HUGE_WAVE = false;
+const uint64_t SEED = 0; // dx_list[i] is simulated with seed derive_seed(SEED, i)
 
 /***** 配置部分结束 *****/
 
@@ -100,7 +101,6 @@ struct XAndDx {
     bool operator>(const float& other) const { return x > other; }
 };
 
-std::mutex mtx;
 const float DEFAULT_MIN = 999.0f;
 const float DEFAULT_MAX = -999.0f;
 
@@ -109,73 +109,80 @@ XAndDx max_x[33][END_TICK - START_TICK + 1];
 
 std::vector<float> dx_list;
 
-void test_one(const zombie_type& type, world& w, size_t dx_idx_start, size_t dx_idx_end)
+struct State {
+    world w;
+    std::vector<XAndDx> min_x;
+    std::vector<XAndDx> max_x;
+};
+
+State make_state()
+{
+    return {world(scene_type::fog),
+        std::vector<XAndDx>(END_TICK - START_TICK + 1, {DEFAULT_MIN, 0.0f}),
+        std::vector<XAndDx>(END_TICK - START_TICK + 1, {DEFAULT_MAX, 0.0f})};
+}
+
+void test_one(const zombie_type& type, State& state, size_t dx_idx)
 {
-    if (!(dx_idx_start < dx_idx_end && dx_idx_end <= dx_list.size())) {
-        std::cout << "ERROR: " << dx_idx_start << " " << dx_idx_end << " " << dx_list.size();
+    if (!(dx_idx < dx_list.size())) {
+        std::cout << "ERROR: " << dx_idx << " " << dx_list.size();
         assert(false);
     }
     auto pos_range = get_pos_range(type);
     auto enter_home_thres = get_enter_home_thres(type);
 
-    XAndDx local_min_x[END_TICK - START_TICK + 1];
-    XAndDx local_max_x[END_TICK - START_TICK + 1];
-    for (size_t i = 0; i < END_TICK - START_TICK + 1; i++) {
-        local_min_x[i] = {DEFAULT_MIN, 0.0f};
-        local_max_x[i] = {DEFAULT_MAX, 0.0f};
-    }
+    auto& w = state.w;
+    auto& local_min_x = state.min_x;
+    auto& local_max_x = state.max_x;
 
-    for (size_t i = dx_idx_start; i < dx_idx_end; i++) {
-        auto dx = dx_list[i];
-
-        for (int pos : {pos_range.first, pos_range.second}) {
-            w.scene.reset();
-            w.scene.stop_spawn = true;
-            w.scene.ignore_game_over = true;
-            w.scene.lock_dx = true;
-            w.scene.lock_dx_val = dx;
-            w.scene.is_zombie_dance = dance_cheat == zombie_dance_cheat::slow;
-            if (ICE_TIME > 0) {
-                w.plant_factory.create(plant_type::iceshroom, 0, 0);
-                run(w, 100 - ICE_TIME);
-            }
+    auto dx = dx_list[dx_idx];
+
+    for (int pos : {pos_range.first, pos_range.second}) {
+        w.scene.reset(derive_seed(SEED, dx_idx));
+        w.scene.stop_spawn = true;
+        w.scene.ignore_game_over = true;
+        w.scene.lock_dx = true;
+        w.scene.lock_dx_val = dx;
+        w.scene.is_zombie_dance = dance_cheat == zombie_dance_cheat::slow;
+        if (ICE_TIME > 0) {
+            w.plant_factory.create(plant_type::iceshroom, 0, 0);
+            run(w, 100 - ICE_TIME);
+        }
+
+        auto& z = w.zombie_factory.create(type);
+        z.x = static_cast<float>(pos);
+        z.int_x = pos;
+        if (z.type == zombie_type::jack_in_the_box) {
+            z.countdown.action = END_TICK + 1;
+        } else if ((z.type == zombie_type::zombie || z.type == zombie_type::conehead
+                       || z.type == zombie_type::buckethead)) {
+            z.dance_cheat = dance_cheat;
+        }
+        run(w, START_TICK);
 
-            auto& z = w.zombie_factory.create(type);
-            z.x = static_cast<float>(pos);
-            z.int_x = pos;
-            if (z.type == zombie_type::jack_in_the_box) {
-                z.countdown.action = END_TICK + 1;
-            } else if ((z.type == zombie_type::zombie || z.type == zombie_type::conehead
-                           || z.type == zombie_type::buckethead)) {
-                z.dance_cheat = dance_cheat;
+        for (int tick = START_TICK; tick <= END_TICK; tick++) {
+            if (local_min_x[tick - START_TICK] > z.x) {
+                local_min_x[tick - START_TICK] = {z.x, dx};
             }
-            run(w, START_TICK);
-
-            for (int tick = START_TICK; tick <= END_TICK; tick++) {
-                if (local_min_x[tick - START_TICK] > z.x) {
-                    local_min_x[tick - START_TICK] = {z.x, dx};
-                }
-                if (local_max_x[tick - START_TICK] < z.x) {
-                    local_max_x[tick - START_TICK] = {z.x, dx};
-                }
-                if (static_cast<int>(z.x) < enter_home_thres) {
-                    break;
-                }
-                run(w, 1);
+            if (local_max_x[tick - START_TICK] < z.x) {
+                local_max_x[tick - START_TICK] = {z.x, dx};
             }
+            if (static_cast<int>(z.x) < enter_home_thres) {
+                break;
+            }
+            run(w, 1);
         }
     }
+}
 
-    std::lock_guard<std::mutex> lock(mtx);
-    for (int tick = START_TICK; tick <= END_TICK; tick++) {
-        int idx = static_cast<int>(type);
-        auto min = local_min_x[tick - START_TICK], max = local_max_x[tick - START_TICK];
-        if (min < min_x[idx][tick - START_TICK]) {
-            min_x[idx][tick - START_TICK] = min;
-        }
-        if (max > max_x[idx][tick - START_TICK]) {
-            max_x[idx][tick - START_TICK] = max;
-        }
+// on ties keep the smallest dx, as a single thread would
+void merge_x(XAndDx& into_min, XAndDx& into_max, const XAndDx& min, const XAndDx& max)
+{
+    if (min < into_min || (min.x == into_min.x && min.dx < into_min.dx)) {
+        into_min = min;
+    }
+    if (max > into_max || (max.x == into_max.x && max.dx < into_max.dx)) {
+        into_max = max;
     }
 }
 
@@ -200,18 +207,22 @@ int main()
         dx_list.push_back(dx);
     }
 
-    std::vector<std::thread> threads;
-    size_t idx = 0;
-    for (int workload :
-        assign_repeat(static_cast<int>(dx_list.size()), std::thread::hardware_concurrency())) {
-        threads.emplace_back([idx, workload]() {
-            world w(scene_type::fog);
-            test_one(ZOMBIE_TYPE, w, idx, idx + static_cast<size_t>(workload));
+    auto total_repeat_num = static_cast<int>(dx_list.size());
+    auto state = run_repeats(
+        total_repeat_num,
+        make_state,
+        [](State& state, int dx_idx) {
+            test_one(ZOMBIE_TYPE, state, static_cast<size_t>(dx_idx));
+        },
+        [](State& into, State& from) {
+            for (size_t i = 0; i < into.min_x.size(); i++) {
+                merge_x(into.min_x[i], into.max_x[i], from.min_x[i], from.max_x[i]);
+            }
         });
-        idx += workload;
-    }
-    for (auto& t : threads) {
-        t.join();
+    for (int tick = START_TICK; tick <= END_TICK; tick++) {
+        int idx = static_cast<int>(ZOMBIE_TYPE);
+        merge_x(min_x[idx][tick - START_TICK], max_x[idx][tick - START_TICK],
+            state->min_x[tick - START_TICK], state->max_x[tick - START_TICK]);
     }
 
     file << "tick,";
@@ -257,7 +268,7 @@ int main()
 
     std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
     std::cout << "耗时 " << std::fixed << std::setprecision(2) << elapsed.count() << " 秒, 使用了 "
-              << threads.size() << " 个线程.";
+              << get_thread_num(total_repeat_num) << " 个线程.";
 
     return 0;
 }
\ No newline at end of file
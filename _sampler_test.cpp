@@ -0,0 +1,82 @@
+/* 检查 weighted_sampler 与每次新建 std::discrete_distribution 的抽样结果一致.
+   用法: _sampler_test [-r <权重组数>] [-s <种子>]
+   每组随机生成 2 ~ 33 个权重, 两种方法用相同种子各抽 50 次, 比较结果与生成器状态,
+   并检查每次抽样消耗的生成器输出个数等于 weighted_sampler::n_draws().
+ */
+
+#include "common/test.h"
+#include "system/rng.h"
+#include "world.h"
+
+using namespace pvz_emulator;
+using namespace pvz_emulator::object;
+using namespace pvz_emulator::system;
+
+const int DRAWS_PER_SET = 50;
+
+// Returns an error message, or an empty string if both paths agree on weights.
+std::string check(scene& s, const std::vector<unsigned int>& weights, uint32_t seed)
+{
+    weighted_sampler sampler(weights);
+
+    std::mt19937 expected_g(seed);
+    std::mt19937 g(seed);
+
+    s.rng.seed(seed);
+    rng r(s);
+
+    for (int i = 0; i < DRAWS_PER_SET; i++) {
+        auto expected = static_cast<size_t>(
+            std::discrete_distribution<>(weights.begin(), weights.end())(expected_g));
+
+        auto g_before = g;
+        auto actual = sampler(g);
+        if (actual != expected) {
+            return "第 " + std::to_string(i) + " 次抽样不同: " + std::to_string(actual)
+                + " != " + std::to_string(expected);
+        }
+        g_before.discard(weighted_sampler::n_draws());
+        if (g_before != g) {
+            return "第 " + std::to_string(i) + " 次抽样消耗的生成器输出个数不是 n_draws() ("
+                + std::to_string(weighted_sampler::n_draws()) + ")";
+        }
+
+        if (r.random_weighted_sample(weights) != expected) {
+            return "rng::random_weighted_sample 第 " + std::to_string(i) + " 次抽样不同";
+        }
+    }
+
+    if (g != expected_g || s.rng != expected_g) {
+        return "抽样后生成器状态不同";
+    }
+    return "";
+}
+
+int main()
+{
+    auto args = parse_cmd_line();
+    auto set_num = std::stoi(get_cmd_arg(args, "r", "1000"));
+    auto seed = get_seed(args);
+
+    auto s = std::make_unique<scene>(scene_type::day); // too large for the stack
+    std::mt19937 gen(derive_seed(seed, 0));
+    for (int i = 0; i < set_num; i++) {
+        size_t size = 2 + gen() % 32;
+
+        std::vector<unsigned int> weights(size);
+        for (auto& weight : weights) {
+            weight = gen() % 5 == 0 ? 0 : static_cast<unsigned int>(gen() % 4000); // some zeros
+        }
+        weights[gen() % size] = static_cast<unsigned int>(1 + gen() % 4000);
+
+        auto error = check(*s, weights, static_cast<uint32_t>(gen()));
+        if (!error.empty()) {
+            std::cout << "第 " << i << " 组权重: " << error << "." << std::endl;
+            return 1;
+        }
+    }
+
+    std::cout << set_num << " 组权重全部一致 (每次抽样消耗 " << weighted_sampler::n_draws()
+              << " 个生成器输出), 随机种子 " << seed << "." << std::endl;
+    return 0;
+}
@@ -45,11 +45,31 @@
     return std::string(sb.GetString()) + "\n";
 }
 
+// Switches off the world::update passes a stop_spawn test scene starts without. Each one comes
+// back on by itself once the scene creates something it handles; the sun pass is kept since it
+// draws from the scene rng.
+void disable_idle_passes(pvz_emulator::world& w)
+{
+    using namespace pvz_emulator::object;
+    w.scene.disabled_passes = static_cast<unsigned int>(update_pass::griditem) |
+        static_cast<unsigned int>(update_pass::projectile) |
+        static_cast<unsigned int>(update_pass::cards) |
+        static_cast<unsigned int>(update_pass::ice_path) |
+        static_cast<unsigned int>(update_pass::endgame);
+}
+
 void run(pvz_emulator::world& w, int ticks)
 {
     assert(ticks >= 0);
-    for (int i = 0; i < ticks; i++)
-        w.update();
+    // world::run stops after an update() returning true; carry on as plain updates would, which
+    // do nothing once the game is over
+    for (auto left = static_cast<unsigned int>(ticks); left > 0;) {
+        unsigned int ticks_run;
+        if (w.run(left, ticks_run) && w.scene.is_game_over) {
+            break;
+        }
+        left -= ticks_run;
+    }
 }
 
 void run(pvz_emulator::world& w, int& curr_tick, int target_tick)
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Threads used by run_repeats for total repeats.
+[[nodiscard]] unsigned int get_thread_num(int total_repeat_num)
+{
+    auto n = std::max(std::thread::hardware_concurrency(), 1u);
+    return std::max(1u, std::min(n, static_cast<unsigned int>(std::max(total_repeat_num, 1))));
+}
+
+// Runs repeats [first_repeat, last_repeat) of a Monte Carlo test on get_thread_num() threads.
+//
+// Each thread builds its own state with make_state() (its world and local accumulators) and
+// calls run_one(state, repeat) for every repeat it takes. Repeats are handed out in small
+// chunks from a shared counter, so a thread that draws short repeats keeps taking work instead
+// of idling at the end. Once a thread runs out of work it merges its neighbours' states into
+// its own with merge(into, from), pairwise in a tree, and the merged state is returned.
+//
+// Which thread runs which repeat depends on timing, so merge must give the same result in any
+// grouping (integer sums, min/max, lists sorted afterwards). Anything order-sensitive, such as
+// float sums, should be stored per repeat and combined by the caller.
+//
+// While it runs, the calling thread prints the progress (repeats per second and time left) to
+// std::cerr once a second.
+template<typename MakeState, typename RunOne, typename Merge>
+auto run_repeats(int first_repeat, int last_repeat, MakeState make_state, RunOne run_one, Merge merge)
+{
+    using State = std::invoke_result_t<MakeState>;
+
+    auto repeat_num = last_repeat - first_repeat;
+    auto thread_num = get_thread_num(repeat_num);
+    auto chunk = std::max(1, repeat_num / static_cast<int>(thread_num * 64));
+
+    std::vector<std::unique_ptr<State>> states(thread_num);
+    std::unique_ptr<std::atomic<bool>[]> is_merged(new std::atomic<bool>[thread_num]);
+    for (unsigned int i = 0; i < thread_num; i++) {
+        is_merged[i] = false;
+    }
+
+    std::atomic<int> next_repeat = first_repeat;
+    std::atomic<int> finished_repeats = 0;
+
+    std::mutex mtx;
+    std::condition_variable cv;
+    bool is_done = false;
+
+    auto work = [&](unsigned int i) {
+        states[i].reset(new State(make_state()));
+
+        for (int first = next_repeat.fetch_add(chunk); first < last_repeat;
+             first = next_repeat.fetch_add(chunk)) {
+            auto last = std::min(first + chunk, last_repeat);
+            for (int r = first; r < last; r++) {
+                run_one(*states[i], r);
+            }
+            finished_repeats += last - first;
+        }
+
+        // thread i merges i + 1, i + 2, i + 4, ... while i is a multiple of twice the stride
+        for (unsigned int stride = 1; stride < thread_num && i % (2 * stride) == 0; stride *= 2) {
+            auto j = i + stride;
+            if (j >= thread_num) {
+                continue;
+            }
+
+            while (!is_merged[j].load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            merge(*states[i], *states[j]);
+            states[j].reset();
+        }
+
+        is_merged[i].store(true, std::memory_order_release);
+
+        if (i == 0) {
+            std::lock_guard<std::mutex> guard(mtx);
+            is_done = true;
+            cv.notify_all();
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 0; i < thread_num; i++) {
+        threads.emplace_back(work, i);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    bool has_progress_line = false;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        while (!cv.wait_for(lock, std::chrono::seconds(1), [&]() { return is_done; })) {
+            std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+            auto finished = finished_repeats.load();
+            auto speed = finished / elapsed.count();
+
+            std::cerr << "\r进度 " << first_repeat + finished << "/" << last_repeat << ", "
+                      << std::fixed << std::setprecision(1) << speed << " 次/秒";
+            if (finished > 0) {
+                std::cerr << ", 预计剩余 " << (repeat_num - finished) / speed << " 秒";
+            }
+            std::cerr << "    " << std::flush;
+            has_progress_line = true;
+        }
+    }
+    if (has_progress_line) {
+        std::cerr << std::endl;
+    }
+
+    for (auto& t : threads) {
+        t.join();
+    }
+
+    return std::move(states[0]);
+}
+
+// Runs repeats [0, total_repeat_num).
+template<typename MakeState, typename RunOne, typename Merge>
+auto run_repeats(int total_repeat_num, MakeState make_state, RunOne run_one, Merge merge)
+{
+    return run_repeats(0, total_repeat_num, make_state, run_one, merge);
+}
+
+// Runs rounds of round_size repeats until is_precise(state, repeat_num) holds after a round or
+// max_repeat_num repeats have run, and returns the merged state with the number of repeats run.
+// Rounds end at fixed repeat counts, so where it stops does not depend on the thread count.
+template<typename MakeState, typename RunOne, typename Merge, typename IsPrecise>
+auto run_repeats_until(int max_repeat_num, int round_size, MakeState make_state, RunOne run_one,
+    Merge merge, IsPrecise is_precise)
+{
+    auto repeat_num = std::min(round_size, max_repeat_num);
+    auto state = run_repeats(0, repeat_num, make_state, run_one, merge);
+
+    while (repeat_num < max_repeat_num && !is_precise(*state, repeat_num)) {
+        auto next_repeat_num = std::min(repeat_num + round_size, max_repeat_num);
+        auto round_state = run_repeats(repeat_num, next_repeat_num, make_state, run_one, merge);
+        merge(*state, *round_state);
+        repeat_num = next_repeat_num;
+    }
+
+    return std::make_pair(std::move(state), repeat_num);
+}
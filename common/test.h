@@ -5,12 +5,14 @@
 
 #include <algorithm>
 #include <codecvt>
+#include <cstdint>
 #include <ctime>
 #include <filesystem>
 #include <fstream>
 #include <iomanip> // std::put_time
 #include <iostream>
 #include <optional>
+#include <random>
 #include <sstream>
 #include <string>
 #include <vector>
@@ -86,21 +88,25 @@ std::vector<std::string> parse_cmd_line()
     return std::find(args.begin(), args.end(), "-" + option) != args.end();
 }
 
-[[nodiscard]] std::vector<int> assign_repeat(int total_repeat_num, int thread_num)
+// Repeat i of a test is seeded with derive_seed(base_seed, i), so every repeat replays the same
+// no matter how the repeats are distributed among threads.
+[[nodiscard]] uint32_t derive_seed(uint64_t base_seed, uint64_t repeat_index)
 {
-    if (total_repeat_num < thread_num) {
-        thread_num = total_repeat_num;
-    }
-
-    int base = total_repeat_num / thread_num;
-    int extra = total_repeat_num % thread_num;
-
-    std::vector<int> repeat_per_thread(thread_num, base);
+    // splitmix64
+    uint64_t z = base_seed + (repeat_index + 1) * 0x9e3779b97f4a7c15ULL;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return static_cast<uint32_t>((z ^ (z >> 31)) >> 32);
+}
 
-    for (int i = 0; i < extra; ++i) {
-        repeat_per_thread[i]++;
+// -s <seed>, a random one if not given
+[[nodiscard]] uint64_t get_seed(const std::vector<std::string>& args)
+{
+    auto seed = get_cmd_arg(args, "s", "");
+    if (seed.empty()) {
+        return std::random_device()();
     }
-    return repeat_per_thread;
+    return std::stoull(seed);
 }
 
 [[nodiscard]] std::vector<std::string> split(const std::string& s, char delim)
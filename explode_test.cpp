@@ -2,16 +2,18 @@
  */
 
 #include "common/pe.h"
+#include "common/runner.h"
 #include "common/test.h"
 #include "seml/explode/lib.h"
 #include "world.h"
 
-#include <mutex>
 #include <optional>
 
 using namespace pvz_emulator;
 using namespace pvz_emulator::object;
 
+const int CI_ROUND_SIZE = 1000;
+
 void validate_config(Config& config)
 {
     if (config.waves.empty()) {
@@ -39,55 +41,52 @@ void validate_config(Config& config)
     }
 }
 
-std::mutex mtx;
-Table table;
+struct State {
+    world w;
+    std::vector<Test> tests; // one per wave, reused across repeats
+    Table table;
+};
 
-void test_one(const Config& config, int repeat)
+void test_one(const std::vector<Program>& programs, State& state, int repeat, uint64_t seed)
 {
-    world w(config.setting.scene_type);
-    Table local_table;
+    auto& w = state.w;
+    auto& tests = state.tests;
+    tests.resize(programs.size());
+    state.table.init(programs);
 
-    for (int r = 0; r < repeat; r++) {
-        std::vector<Test> tests;
-        tests.reserve(config.waves.size());
+    // the per-wave resets below draw their seeds from this one
+    w.scene.reset(derive_seed(seed, repeat));
 
-        for (const auto& wave : config.waves) {
-            Test test;
-            load_wave(config.setting, wave, test);
+    for (size_t i = 0; i < programs.size(); i++) {
+        const auto& program = programs[i];
+        auto& test = tests[i];
+        load_wave(program, test);
 
-            w.scene.reset();
-            w.scene.stop_spawn = true;
+        w.scene.reset();
+        w.scene.stop_spawn = true;
+        disable_idle_passes(w);
 
-            auto it = test.ops.begin();
-            int curr_tick = it->tick; // there is at least 1 op (setup)
+        auto it = program.ops.begin();
+        int curr_tick = it->tick; // there is at least 1 op (setup)
 
-            for (; it != test.ops.end() && it->tick < wave.start_tick; it++) {
-                run(w, curr_tick, it->tick);
-                it->f(w);
-            }
-            run(w, curr_tick, wave.start_tick);
+        for (; it != program.ops.end() && it->tick < program.start_tick; it++) {
+            run(w, curr_tick, it->tick);
+            run_op(w, program, *it, test);
+        }
+        run(w, curr_tick, program.start_tick);
 
-            while (curr_tick <= wave.wave_length) {
-                for (; it != test.ops.end() && it->tick == curr_tick; it++) {
-                    it->f(w);
-                }
+        while (curr_tick <= program.wave_length) {
+            for (; it != program.ops.end() && it->tick == curr_tick; it++) {
+                run_op(w, program, *it, test);
+            }
 
-                std::array<LossInfo, 6> loss_info = {};
-                for (const auto& plant : test.protect_plants) {
-                    loss_info[plant->row] = {plant->explode, plant->max_hp - plant->hp};
-                };
-                test.loss_infos.push_back(loss_info);
+            state.table.add_loss(i, curr_tick, test);
 
-                run(w, curr_tick, curr_tick + 1);
-            }
-            tests.push_back(std::move(test));
+            run(w, curr_tick, curr_tick + 1);
         }
-
-        local_table.update(tests);
     }
 
-    std::lock_guard<std::mutex> guard(mtx);
-    table.merge(local_table);
+    state.table.finish_repeat();
 }
 
 int main()
@@ -99,19 +98,42 @@ int main()
     auto args = parse_cmd_line();
     auto config_file = get_cmd_arg(args, "f");
     auto output_file = get_cmd_arg(args, "o", "explode_test");
-    auto total_repeat_num = std::stoi(get_cmd_arg(args, "r", "10000"));
+    auto ci_width = get_cmd_arg(args, "ci", ""); // with -ci, -r is the maximum
+    auto total_repeat_num = std::stoi(get_cmd_arg(args, "r", ci_width.empty() ? "10000" : "100000"));
+    auto seed = get_seed(args);
 
     auto [file, full_output_file] = open_csv(output_file);
 
     auto config = read_json(config_file);
     validate_config(config);
 
-    std::vector<std::thread> threads;
-    for (int repeat : assign_repeat(total_repeat_num, std::thread::hardware_concurrency())) {
-        threads.emplace_back([config, repeat]() { test_one(config, repeat); });
+    std::vector<Program> programs;
+    programs.reserve(config.waves.size());
+    for (const auto& wave : config.waves) {
+        programs.push_back(compile_wave(config.setting, wave));
     }
-    for (auto& t : threads) {
-        t.join();
+
+    auto make_state = [&]() { return State {world(config.setting.scene_type), {}, {}}; };
+    auto run_one = [&](State& state, int repeat) { test_one(programs, state, repeat, seed); };
+    auto merge = [](State& into, State& from) { into.table.merge(from.table); };
+
+    Table table;
+    if (ci_width.empty()) {
+        table = run_repeats(total_repeat_num, make_state, run_one, merge)->table;
+    } else {
+        // stop once every tick's mean loss is known to within ±ci_width
+        auto max_half_width = std::stod(ci_width);
+        auto [state, repeat_num] = run_repeats_until(total_repeat_num, CI_ROUND_SIZE, make_state,
+            run_one, merge, [&](const State& state, int) {
+                for (size_t i = 0; i < state.table.test_infos.size(); i++) {
+                    if (state.table.get_max_ci_half_width(i) > max_half_width) {
+                        return false;
+                    }
+                }
+                return true;
+            });
+        table = std::move(state->table);
+        total_repeat_num = repeat_num;
     }
 
     std::vector<std::vector<std::string>> headers(config.waves.size());
@@ -218,10 +240,18 @@ int main()
         file << "\n";
     }
 
+    if (!ci_width.empty()) {
+        file << "\n95%置信区间半宽,";
+        for (size_t i = 0; i < table.test_infos.size(); i++) {
+            file << std::fixed << std::setprecision(2) << table.get_max_ci_half_width(i) << ",";
+        }
+        file << "\n重复次数," << total_repeat_num << "\n";
+    }
+
     std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
     std::cout << "输出文件已保存至 " << full_output_file << ".\n"
               << "耗时 " << std::fixed << std::setprecision(2) << elapsed.count() << " 秒, 使用了 "
-              << threads.size() << " 个线程." << std::endl;
+              << get_thread_num(total_repeat_num) << " 个线程, 随机种子 " << seed << "." << std::endl;
 
     return 0;
 }
\ No newline at end of file
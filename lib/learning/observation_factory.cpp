@@ -1,6 +1,6 @@
-#include <thread>
 #include <algorithm>
 #include "observation_factory.h"
+#include "thread_pool.h"
 
 namespace pvz_emulator::learning {
 
@@ -45,20 +45,37 @@ void observation_factory::create(
     ob.clear();
     ob.resize(worlds.size() * row_size, 0);
 
-    std::atomic<decltype(worlds.size())> i = 0;
-    std::vector<std::thread> threads;
+    thread_pool::global()->parallel_for(worlds.size(), [&](size_t k) {
+        create(*worlds[k], action_masks[k], &ob[row_size * k]);
+    });
+}
 
-    for (unsigned int j = 0; j < std::thread::hardware_concurrency(); j++) {
-        threads.emplace_back([&]() {
-            for (auto k = i.fetch_add(1); k < worlds.size(); k = i.fetch_add(1)) {
-                create(*worlds[k], action_masks[k], &ob[row_size * k]);
-            }
-        });
-    }
+void observation_factory::update_and_create(
+    std::vector<world *> &worlds,
+    const world::action_vector &all_actions,
+    world::action_vector &actions,
+    world::batch_action_masks &action_masks,
+    const world::check_list &build_check_list,
+    std::vector<int> &check_result,
+    std::vector<int> &done,
+    std::vector<float> &ob,
+    unsigned int frames)
+{
+    // get_available_actions always yields one mask per action plus the no-op
+    auto row_size = single_size + all_actions.size() + 1;
 
-    for (auto& t: threads) {
-        t.join();
-    }
+    done.resize(worlds.size());
+    check_result.resize(worlds.size());
+    action_masks.resize(worlds.size());
+    ob.clear();
+    ob.resize(worlds.size() * row_size, 0);
+
+    thread_pool::global()->parallel_for(worlds.size(), [&](size_t k) {
+        auto& w = *worlds[k];
+        done[k] = w.step(
+            all_actions, actions[k], action_masks[k], build_check_list, check_result[k], frames);
+        create(w, action_masks[k], &ob[row_size * k]);
+    });
 }
 
 void observation_factory::create(
@@ -72,11 +89,60 @@ void observation_factory::create(
     create(world, action_masks, ob.data());
 }
 
+void observation_factory::create(
+    std::vector<world *> &worlds,
+    const int8_t *masks,
+    size_t n_masks,
+    float *ob)
+{
+    auto row_size = single_size + n_masks;
+
+    thread_pool::global()->parallel_for(worlds.size(), [&](size_t k) {
+        auto row = ob + row_size * k;
+        std::fill(row, row + single_size, 0.0f);
+
+        auto mask_row = masks + n_masks * k;
+        std::copy(mask_row, mask_row + n_masks, encode(*worlds[k], row));
+    });
+}
+
+void observation_factory::update_and_create(
+    std::vector<world *> &worlds,
+    const world::action_vector &all_actions,
+    const world::action_vector &actions,
+    const world::check_list &build_check_list,
+    int8_t *masks,
+    int *check_result,
+    int *done,
+    float *ob,
+    unsigned int frames)
+{
+    auto n_masks = all_actions.size() + 1;
+    auto row_size = single_size + n_masks;
+
+    thread_pool::global()->parallel_for(worlds.size(), [&](size_t k) {
+        thread_local world::action_masks world_masks;
+
+        auto& w = *worlds[k];
+        done[k] = w.step(
+            all_actions, actions[k], world_masks, build_check_list, check_result[k], frames);
+        std::copy(world_masks.cbegin(), world_masks.cend(), masks + n_masks * k);
+
+        auto row = ob + row_size * k;
+        std::fill(row, row + single_size, 0.0f);
+        std::copy(world_masks.cbegin(), world_masks.cend(), encode(w, row));
+    });
+}
+
 void observation_factory::create(
     world &w,
     const world::action_masks& masks,
     float *base)
 {
+    std::copy(masks.cbegin(), masks.cend(), encode(w, base));
+}
+
+float *observation_factory::encode(world &w, float *base) {
     auto& scene = w.scene;
 
     base = fill_ob_vector<zombie>(
@@ -177,8 +243,7 @@ void observation_factory::create(
     base[6] = static_cast<float>(scene.sun.sun) / 9990.0;
     base[7] = static_cast<float>(scene.spawn.total_flags);
 
-    base += meta_size;
-    std::copy(masks.cbegin(), masks.cend(), base);
+    return base + meta_size;
 }
 
 }
@@ -1,30 +1,34 @@
 #pragma once
 #include <vector>
-#include <functional>
+#include <cstdint>
 #include "world.h"
 
 namespace pvz_emulator::learning {
 
 class observation_factory {
 private:
-    template<class T, size_t S>
+    // Encodes the first max live objects of list, size floats each, via cb(float *a, const T&);
+    // slots past the last object are left as they are. Returns the end of the max slots.
+    template<class T, size_t S, typename F>
     float *fill_ob_vector(
         pvz_emulator::object::obj_list<T, S>& list,
         float *base,
         unsigned int size,
         unsigned int max,
-        std::function<void (float *base, const T& t)> cb)
+        F cb)
     {
-        auto n = list.size() < max ? list.size() : max;
-        auto it = list.begin();
+        unsigned int i = 0;
 
-        for (unsigned i = 0; i < n; i++) {
+        for (auto it = list.begin(); i < max && it != list.end(); ++it, i++) {
             cb(base + size * i, *it);
         }
 
         return base + size * max;
     }
 
+    // Writes everything but the action masks and returns where the masks go.
+    float *encode(world& w, float *base);
+
 public:
     unsigned int num_zombies;
     unsigned int num_plants;
@@ -58,6 +62,39 @@ public:
         std::vector<world *> &worlds,
         const world::batch_action_masks& action_masks,
         std::vector<float> &ob);
+
+    // world::update_all followed by the batch create, done as one task per world so each
+    // world is visited once per step.
+    void update_and_create(
+        std::vector<world *> &worlds,
+        const world::action_vector &all_actions,
+        world::action_vector &actions,
+        world::batch_action_masks &action_masks,
+        const world::check_list &build_check_list,
+        std::vector<int> &check_result,
+        std::vector<int> &done,
+        std::vector<float> &ob,
+        unsigned int frames = 1);
+
+    // The batch calls over caller-owned buffers, e.g. NumPy arrays: masks holds one row of
+    // n_masks (all_actions.size() + 1) int8 values per world, ob one row of single_size +
+    // n_masks floats, and check_result / done one int per world.
+    void create(
+        std::vector<world *> &worlds,
+        const int8_t *masks,
+        size_t n_masks,
+        float *ob);
+
+    void update_and_create(
+        std::vector<world *> &worlds,
+        const world::action_vector &all_actions,
+        const world::action_vector &actions,
+        const world::check_list &build_check_list,
+        int8_t *masks,
+        int *check_result,
+        int *done,
+        float *ob,
+        unsigned int frames = 1);
 };
 
 }
@@ -0,0 +1,174 @@
+#include <memory>
+#include <algorithm>
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "thread_pool.h"
+
+namespace pvz_emulator::learning {
+
+namespace {
+
+thread_local bool is_pool_thread = false;
+
+std::mutex global_mtx;
+std::shared_ptr<thread_pool> global_pool;
+
+// Marks the calling thread as running pool work for its lifetime.
+class pool_thread_guard {
+public:
+    pool_thread_guard() {
+        is_pool_thread = true;
+    }
+
+    ~pool_thread_guard() {
+        is_pool_thread = false;
+    }
+};
+
+void pin_to_cpu(std::thread& t, unsigned int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % CPU_SETSIZE, &set);
+    pthread_setaffinity_np(t.native_handle(), sizeof(set), &set);
+#else
+    (void)t;
+    (void)cpu;
+#endif
+}
+
+}
+
+thread_pool::thread_pool(unsigned int n_threads, bool pin) :
+    job(nullptr),
+    job_size(0),
+    next_index(0),
+    n_busy(0),
+    generation(0),
+    is_stopping(false)
+{
+    if (n_threads == 0) {
+        n_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+
+    for (unsigned int i = 1; i < n_threads; i++) {
+        workers.emplace_back([this]() { worker_main(); });
+
+        if (pin) {
+            pin_to_cpu(workers.back(), i);
+        }
+    }
+}
+
+thread_pool::~thread_pool() {
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        is_stopping = true;
+    }
+
+    start_cv.notify_all();
+
+    for (auto& t : workers) {
+        t.join();
+    }
+}
+
+void thread_pool::work() {
+    for (auto i = next_index.fetch_add(1); i < job_size; i = next_index.fetch_add(1)) {
+        try {
+            (*job)(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> guard(mtx);
+            if (!job_error) {
+                job_error = std::current_exception();
+            }
+            next_index = job_size;
+        }
+    }
+}
+
+void thread_pool::worker_main() {
+    is_pool_thread = true;
+
+    unsigned long long seen = 0;
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while (true) {
+        start_cv.wait(lock, [&]() { return is_stopping || generation != seen; });
+
+        if (is_stopping) {
+            return;
+        }
+
+        seen = generation;
+        lock.unlock();
+
+        work();
+
+        lock.lock();
+        if (--n_busy == 0) {
+            done_cv.notify_one();
+        }
+    }
+}
+
+void thread_pool::parallel_for(size_t n, const std::function<void(size_t)>& f) {
+    if (is_pool_thread || workers.empty() || n <= 1) {
+        for (size_t i = 0; i < n; i++) {
+            f(i);
+        }
+        return;
+    }
+
+    std::lock_guard<std::mutex> call_guard(call_mtx);
+
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        job = &f;
+        job_size = n;
+        next_index = 0;
+        n_busy = static_cast<unsigned int>(workers.size());
+        generation++;
+    }
+
+    start_cv.notify_all();
+
+    {
+        pool_thread_guard guard;
+        work();
+    }
+
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        done_cv.wait(lock, [this]() { return n_busy == 0; });
+        job = nullptr;
+        std::swap(error, job_error);
+    }
+
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+std::shared_ptr<thread_pool> thread_pool::global() {
+    std::lock_guard<std::mutex> guard(global_mtx);
+
+    if (!global_pool) {
+        global_pool = std::make_shared<thread_pool>();
+    }
+
+    return global_pool;
+}
+
+void thread_pool::configure(unsigned int n_threads, bool pin) {
+    auto pool = std::make_shared<thread_pool>(n_threads, pin);
+
+    std::lock_guard<std::mutex> guard(global_mtx);
+    global_pool.swap(pool);
+    // the old pool, now in pool, is destroyed once no caller holds it any more
+}
+
+}
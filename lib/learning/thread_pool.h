@@ -0,0 +1,63 @@
+#pragma once
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <condition_variable>
+#include <exception>
+#include <memory>
+
+namespace pvz_emulator::learning {
+
+// Workers that live for the whole process, so a batch step does not pay for creating and
+// joining threads. parallel_for hands out indices one at a time from a shared counter, so a
+// worker that finishes early keeps taking work from the rest of the batch.
+class thread_pool {
+    std::vector<std::thread> workers;
+
+    std::mutex mtx;
+    std::condition_variable start_cv;
+    std::condition_variable done_cv;
+    std::mutex call_mtx;
+
+    // Current job, published under mtx by bumping generation.
+    const std::function<void(size_t)>* job;
+    std::exception_ptr job_error; // first exception thrown by the job, under mtx
+    size_t job_size;
+    std::atomic<size_t> next_index;
+    unsigned int n_busy;
+    unsigned long long generation;
+    bool is_stopping;
+
+    void work();
+    void worker_main();
+
+public:
+    // n_threads workers, including the calling thread, which joins in on every parallel_for;
+    // 0 means std::thread::hardware_concurrency(). With pin, worker i is bound to CPU i where
+    // the platform supports it.
+    explicit thread_pool(unsigned int n_threads = 0, bool pin = false);
+    ~thread_pool();
+
+    thread_pool(const thread_pool&) = delete;
+    thread_pool& operator=(const thread_pool&) = delete;
+
+    unsigned int size() const {
+        return static_cast<unsigned int>(workers.size()) + 1;
+    }
+
+    // Calls f(i) for every i in [0, n) and returns once all calls have finished. Calls from
+    // inside f run inline, and concurrent callers take turns. If a call throws, no further
+    // indices are handed out and the first exception is rethrown once the others have finished.
+    void parallel_for(size_t n, const std::function<void(size_t)>& f);
+
+    // The pool shared by world::update_all and observation_factory. Callers keep the returned
+    // pointer for the length of their call, so configure() never destroys a pool in use.
+    static std::shared_ptr<thread_pool> global();
+
+    // Replaces the shared pool; the old one is destroyed once its last call has returned.
+    static void configure(unsigned int n_threads, bool pin = false);
+};
+
+}
@@ -0,0 +1,197 @@
+#include <algorithm>
+#include <stdexcept>
+#include <utility>
+#include "vector_env.h"
+#include "thread_pool.h"
+
+namespace pvz_emulator::learning {
+
+using namespace pvz_emulator::object;
+
+vector_env::vector_env(
+        scene_type type,
+        unsigned int n,
+        const world::action_vector& all_actions,
+        unsigned int num_zombies,
+        unsigned int num_plants,
+        unsigned int num_projectiles,
+        unsigned int num_griditems,
+        uint32_t seed,
+        const std::vector<plant_type>& cards,
+        plant_type imitater_type,
+        const world::check_list& build_check_list,
+        unsigned int frames) :
+    factory(type, num_zombies, num_plants, num_projectiles, num_griditems),
+    all_actions(all_actions),
+    build_check_list(build_check_list),
+    cards(cards),
+    imitater_type(imitater_type),
+    frames(std::max(frames, 1u)),
+    front(0),
+    is_step_pending(false),
+    is_step_requested(false),
+    is_step_running(false),
+    is_stopping(false)
+{
+    worlds.reserve(n);
+    for (unsigned int i = 0; i < n; i++) {
+        worlds.emplace_back(type, seed + i);
+    }
+
+    for (auto& b : buffers) {
+        b.ob.resize(n * row_size(), 0);
+        b.masks.resize(n * n_masks(), 0);
+        b.check_result.resize(n, 0);
+        b.done.resize(n, 0);
+    }
+
+    stepper = std::thread([this]() { stepper_main(); });
+}
+
+vector_env::~vector_env() {
+    {
+        std::unique_lock<std::mutex> lock(mtx);
+        cv.wait(lock, [this]() { return !is_step_requested && !is_step_running; });
+        is_stopping = true;
+    }
+
+    cv.notify_all();
+    stepper.join();
+}
+
+void vector_env::reset_world(size_t k, buffer& b) {
+    auto& w = worlds[k];
+
+    w.reset();
+    if (!cards.empty()) {
+        w.select_plants(cards, imitater_type);
+    }
+
+    thread_local world::action_masks masks;
+    w.get_available_actions(all_actions, masks);
+    b.check_result[k] = w.check_build(build_check_list);
+    std::copy(masks.cbegin(), masks.cend(), b.masks.begin() + n_masks() * k);
+
+    auto row = b.ob.data() + row_size() * k;
+    std::fill(row, row + factory.single_size, 0.0f);
+    factory.create(w, masks, row);
+}
+
+void vector_env::step_world(size_t k, buffer& b) {
+    auto& w = worlds[k];
+
+    auto a = pending_actions[k];
+    auto action = a >= 0 && static_cast<size_t>(a) < all_actions.size() ?
+        all_actions[a] :
+        std::make_tuple(-1, -1, -1);
+
+    thread_local world::action_masks masks;
+    b.done[k] = w.step(all_actions, action, masks, build_check_list, b.check_result[k], frames);
+
+    if (b.done[k]) {
+        auto check_result = b.check_result[k];
+        reset_world(k, b);
+        b.check_result[k] = check_result;
+        return;
+    }
+
+    std::copy(masks.cbegin(), masks.cend(), b.masks.begin() + n_masks() * k);
+
+    auto row = b.ob.data() + row_size() * k;
+    std::fill(row, row + factory.single_size, 0.0f);
+    factory.create(w, masks, row);
+}
+
+void vector_env::stepper_main() {
+    std::unique_lock<std::mutex> lock(mtx);
+
+    while (true) {
+        cv.wait(lock, [this]() { return is_stopping || is_step_requested; });
+
+        if (is_stopping) {
+            return;
+        }
+
+        is_step_requested = false;
+        is_step_running = true;
+        lock.unlock();
+
+        auto& b = buffers[front ^ 1];
+        std::exception_ptr error;
+        try {
+            thread_pool::global()->parallel_for(worlds.size(), [&](size_t k) { step_world(k, b); });
+        } catch (...) {
+            error = std::current_exception();
+        }
+
+        lock.lock();
+        step_error = error;
+        is_step_running = false;
+        cv.notify_all();
+    }
+}
+
+const vector_env::buffer& vector_env::reset() {
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (is_step_pending) {
+            throw std::logic_error("reset while a step is pending; call step_wait first");
+        }
+    }
+
+    // like step_wait, leave the buffer of the last result alone
+    auto& b = buffers[front ^ 1];
+    std::fill(b.done.begin(), b.done.end(), 0);
+
+    thread_pool::global()->parallel_for(worlds.size(), [&](size_t k) { reset_world(k, b); });
+
+    front ^= 1;
+    return b;
+}
+
+world& vector_env::get_world(size_t i) {
+    std::lock_guard<std::mutex> guard(mtx);
+    if (is_step_pending) {
+        throw std::logic_error("get_world while a step is pending; call step_wait first");
+    }
+
+    return worlds.at(i);
+}
+
+void vector_env::step_async(const std::vector<int>& actions) {
+    if (actions.size() != worlds.size()) {
+        throw std::invalid_argument("need one action per world");
+    }
+
+    {
+        std::lock_guard<std::mutex> guard(mtx);
+        if (is_step_pending) {
+            throw std::logic_error("step_async while a step is pending; call step_wait first");
+        }
+
+        pending_actions = actions;
+        is_step_pending = true;
+        is_step_requested = true;
+    }
+
+    cv.notify_all();
+}
+
+const vector_env::buffer& vector_env::step_wait() {
+    std::unique_lock<std::mutex> lock(mtx);
+    if (!is_step_pending) {
+        throw std::logic_error("step_wait without a pending step; call step_async first");
+    }
+    cv.wait(lock, [this]() { return !is_step_requested && !is_step_running; });
+
+    is_step_pending = false;
+    if (step_error) {
+        // the failed batch may be partly written; keep showing the previous one
+        std::rethrow_exception(std::exchange(step_error, nullptr));
+    }
+
+    front ^= 1;
+    return buffers[front];
+}
+
+}
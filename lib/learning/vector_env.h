@@ -0,0 +1,115 @@
+#pragma once
+#include <vector>
+#include <array>
+#include <thread>
+#include <mutex>
+#include <cstdint>
+#include <condition_variable>
+#include <exception>
+#include "world.h"
+#include "observation_factory.h"
+
+namespace pvz_emulator::learning {
+
+// N worlds stepped as one batch, with finished episodes reset on the spot (the observation
+// returned for them is the first one of the new episode). step_async hands the batch to a
+// background thread, which runs it on the shared thread_pool while the caller computes the next
+// actions. Results alternate between two buffers: a step_wait result stays valid until the
+// step_wait after the next one.
+class vector_env {
+public:
+    struct buffer {
+        std::vector<float> ob;
+        std::vector<int8_t> masks;
+        std::vector<int> check_result;
+        std::vector<int> done;
+    };
+
+private:
+    std::vector<world> worlds;
+    observation_factory factory;
+
+    world::action_vector all_actions;
+    world::check_list build_check_list;
+    std::vector<object::plant_type> cards;
+    object::plant_type imitater_type;
+    unsigned int frames;
+
+    std::array<buffer, 2> buffers;
+    unsigned int front;
+
+    std::vector<int> pending_actions;
+
+    std::thread stepper;
+    std::mutex mtx;
+    std::condition_variable cv;
+    // pending: between step_async and step_wait; requested / running: the stepper's state
+    bool is_step_pending;
+    bool is_step_requested;
+    bool is_step_running;
+    bool is_stopping;
+    std::exception_ptr step_error; // thrown by the stepper's batch, rethrown by step_wait
+
+    void stepper_main();
+    void step_world(size_t k, buffer& b);
+    void reset_world(size_t k, buffer& b);
+
+public:
+    vector_env(
+        object::scene_type type,
+        unsigned int n,
+        const world::action_vector& all_actions,
+        unsigned int num_zombies,
+        unsigned int num_plants,
+        unsigned int num_projectiles,
+        unsigned int num_griditems,
+        uint32_t seed = 0,
+        const std::vector<object::plant_type>& cards = {},
+        object::plant_type imitater_type = object::plant_type::none,
+        const world::check_list& build_check_list = {},
+        unsigned int frames = 1);
+
+    ~vector_env();
+
+    vector_env(const vector_env&) = delete;
+    vector_env& operator=(const vector_env&) = delete;
+
+    size_t size() const {
+        return worlds.size();
+    }
+
+    // Observation row length: factory.single_size plus one mask per action and the no-op.
+    size_t row_size() const {
+        return factory.single_size + n_masks();
+    }
+
+    size_t n_masks() const {
+        return all_actions.size() + 1;
+    }
+
+    // Throws std::logic_error between step_async and step_wait, while the stepper owns the worlds.
+    world& get_world(size_t i);
+
+    const observation_factory& get_factory() const {
+        return factory;
+    }
+
+    // Resets every world and returns the initial buffer, with done all 0. Like step_wait, it writes
+    // the other buffer, so the previous result stays valid until the next step_async.
+    const buffer& reset();
+
+    // actions[k] indexes all_actions for world k; all_actions.size() is the no-op. Must be
+    // followed by step_wait before the next step_async or reset, which otherwise throw
+    // std::logic_error (as does step_wait without a step_async). For a world whose episode
+    // ended, check_result is from its last step and ob / masks are from the new episode.
+    void step_async(const std::vector<int>& actions);
+
+    const buffer& step_wait();
+
+    const buffer& step(const std::vector<int>& actions) {
+        step_async(actions);
+        return step_wait();
+    }
+};
+
+}
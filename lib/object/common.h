@@ -5,8 +5,6 @@
 
 namespace pvz_emulator::object {
 
-int get_uuid();
-
 struct rect {
     int x;
     int y;
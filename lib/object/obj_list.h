@@ -3,39 +3,130 @@
 #include<cstring>
 #include<cstddef>
 #include<cassert>
+#include<cstdint>
+#include<algorithm>
 #include<array>
+#include<new>
+#include<vector>
+
+#ifdef _MSC_VER
+#include<intrin.h>
+#endif
 
 namespace pvz_emulator::object {
 
+inline unsigned int count_trailing_zeros(uint64_t x) {
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanForward64(&i, x);
+	return static_cast<unsigned int>(i);
+#else
+	return static_cast<unsigned int>(__builtin_ctzll(x));
+#endif
+}
+
+inline unsigned int highest_bit(uint64_t x) {
+#ifdef _MSC_VER
+	unsigned long i;
+	_BitScanReverse64(&i, x);
+	return static_cast<unsigned int>(i);
+#else
+	return 63 - static_cast<unsigned int>(__builtin_clzll(x));
+#endif
+}
+
+inline unsigned int popcount(uint64_t x) {
+#ifdef _MSC_VER
+	return static_cast<unsigned int>(__popcnt64(x));
+#else
+	return static_cast<unsigned int>(__builtin_popcountll(x));
+#endif
+}
+
+// Fixed capacity object pool.
+//
+// Live slots are tracked in an occupancy bitmap, so iteration only touches allocated objects.
+// Destroyed objects stay readable (and are skipped by iteration through is_freeable()) until the
+// next shrink_to_fit, which recycles the slots handed to release() since the last call, plus any
+// slot allocated since then that is already freeable (e.g. a reused slot whose flags were left set).
+// Slot reuse order is the highest recycled slot below active_end first, then active_end itself.
 template<typename T, size_t S> class obj_list {
+public:
+	static constexpr size_t N_WORDS = (S + 63) / 64;
+
+	// A set of slot indices, one bit per slot. Bits of freed slots may linger until the slot is
+	// reused; subset iteration only yields active objects.
+	using index_set = std::array<uint64_t, N_WORDS>;
+
+private:
 	class obj_wrap {
 	protected:
 		T t;
 		size_t next_available;
-		
+
 		obj_wrap():t(), next_available(0) {}
 		friend class obj_list;
 	};
 
+	// Visits live slots in order, optionally restricted to the union of sets[k] for every bit k of
+	// selected. The bitmaps and active_end are re-read on every step, so objects allocated while
+	// iterating are visited too.
 	class iterator {
 	private:
-		int i;
-		obj_list& list;
+		size_t i;
+		obj_list* list;
+		const index_set* sets;
+		unsigned int selected;
+
+		uint64_t word(size_t w) const {
+			auto bits = list->live[w];
+
+			if (sets != nullptr) {
+				uint64_t mask = 0;
+				for (auto m = selected; m; m &= m - 1) {
+					mask |= sets[count_trailing_zeros(m)][w];
+				}
+				bits &= mask;
+			}
+
+			return bits;
+		}
+
+		void seek() {
+			while (i < list->active_end) {
+				auto w = i / 64;
+				auto bits = word(w) & (~uint64_t(0) << (i % 64));
+
+				if (bits == 0) {
+					i = (w + 1) * 64;
+					continue;
+				}
+
+				i = w * 64 + count_trailing_zeros(bits);
+				if (!list->a[i].t.is_freeable()) {
+					return;
+				}
 
-	public:
-		explicit iterator(int n, obj_list& l): i(n), list(l) {
-			while (i < list.active_end &&
-				(list.a[i].t.is_freeable() || list.a[i].next_available != i))
-			{
 				i++;
 			}
 		}
-		
+
+		bool is_end() const {
+			return i >= list->active_end;
+		}
+
+	public:
+		explicit iterator(obj_list& l, const index_set* s = nullptr, unsigned int sel = 0):
+			i(0), list(&l), sets(s), selected(sel)
+		{
+			seek();
+		}
+
+		explicit iterator(size_t n, obj_list& l): i(n), list(&l), sets(nullptr), selected(0) {}
+
 		iterator& operator++() {
-			do {
-				i++;
-			} while (i < list.active_end &&
-				(list.a[i].t.is_freeable() || list.a[i].next_available != i));
+			i++;
+			seek();
 			return *this;
 		}
 
@@ -46,15 +137,7 @@ template<typename T, size_t S> class obj_list {
 		}
 
 		bool operator==(const iterator& other) const {
-			if (other.i == i) {
-				return true;
-			} else if (i == -1) {
-				return other.i >= list.active_end;
-			} else if (other.i == -1) {
-				return static_cast<size_t>(i) >= list.active_end;
-			} else {
-				return false;
-			}
+			return i == other.i || (is_end() && other.is_end());
 		}
 
 		bool operator!=(const iterator& other) const {
@@ -62,48 +145,111 @@ template<typename T, size_t S> class obj_list {
 		}
 
 		T& operator*() const {
-			return list.a[i].t;
+			return list->a[i].t;
+		}
+	};
+
+	class subset_range {
+		obj_list& list;
+		const index_set* sets;
+		unsigned int selected;
+
+	public:
+		subset_range(obj_list& l, const index_set* s, unsigned int sel):
+			list(l), sets(s), selected(sel) {}
+
+		iterator begin() const {
+			return iterator(list, sets, selected);
+		}
+
+		iterator end() const {
+			return list.end();
 		}
 	};
 
 	obj_wrap a[S];
-	size_t next_available;
 	size_t active_end;
 	size_t n_actives;
+	// every slot at or above this is still zeroed
+	size_t dirty_end;
+
+	// allocated and not yet recycled, always below active_end
+	index_set live;
+	// recycled slots below active_end waiting to be reused
+	index_set reusable;
+	// slots released since the last shrink_to_fit
+	index_set pending;
+	// slots allocated since the last shrink_to_fit
+	index_set fresh;
+	bool has_pending;
+
+	void clear_bits(size_t n_words) {
+		std::fill_n(live.begin(), n_words, 0);
+		std::fill_n(reusable.begin(), n_words, 0);
+		std::fill_n(pending.begin(), n_words, 0);
+		std::fill_n(fresh.begin(), n_words, 0);
+		has_pending = false;
+	}
+
 public:
 	explicit obj_list() :
-		next_available(0),
 		active_end(0),
-		n_actives(0)
+		n_actives(0),
+		dirty_end(0)
 	{
 		memset(a, 0, sizeof(a));
+		clear_bits(N_WORDS);
 	}
 
 	T& alloc() {
-		size_t i;
+		size_t i = S;
 
-		if (next_available > S) {
-			throw std::bad_alloc();
+		for (auto w = (active_end + 63) / 64; w-- > 0;) {
+			if (reusable[w]) {
+				i = w * 64 + highest_bit(reusable[w]);
+				reusable[w] &= ~(uint64_t(1) << (i % 64));
+				break;
+			}
 		}
 
-		if (next_available >= active_end) {
+		if (i == S) {
 			if (active_end < S) {
-				i = active_end;
-				next_available = ++active_end;
+				i = active_end++;
+				dirty_end = std::max(dirty_end, active_end);
 			} else {
 				throw std::bad_alloc();
 			}
-		} else {
-			i = next_available;
-			next_available = std::min(a[i].next_available, active_end);
 		}
 
 		a[i].next_available = i;
+		live[i / 64] |= uint64_t(1) << (i % 64);
+		fresh[i / 64] |= uint64_t(1) << (i % 64);
+		has_pending = true;
 		++n_actives;
 
 		return a[i].t;
 	}
 
+	// Hands p's slot back for reuse at the next shrink_to_fit. p must already be freeable.
+	void release(const T& p) {
+		auto i = slot_of(p);
+
+		pending[i / 64] |= uint64_t(1) << (i % 64);
+		has_pending = true;
+	}
+
+	// Slot of p, which must live in this list, whether or not it is still active.
+	size_t slot_of(const T& p) const {
+		auto i = static_cast<size_t>(reinterpret_cast<const obj_wrap*>(&p) - a);
+		assert(i < S);
+		return i;
+	}
+
+	T& slot(size_t i) {
+		assert(i < S);
+		return a[i].t;
+	}
+
 	T* get(int i) {
 		if (i >= S || i < 0) {
 			return nullptr;
@@ -136,31 +282,51 @@ public:
 		return ow - a == i;
 	}
 
+	// Recycles the slots released since the last call; costs nothing when nothing was allocated
+	// or released.
 	void shrink_to_fit() {
-		n_actives = 0;
-		size_t last = 0;
+		if (!has_pending) {
+			return;
+		}
 
-		for (auto i = 0ul; i < active_end; i++) {
-			if (a[i].next_available == i && !a[i].t.is_freeable()) {
-				last = i + 1;
-				n_actives++;
+		for (size_t w = 0; w < N_WORDS; w++) {
+			for (auto bits = fresh[w] & ~pending[w]; bits; bits &= bits - 1) {
+				if (a[w * 64 + count_trailing_zeros(bits)].t.is_freeable()) {
+					pending[w] |= bits & (~bits + 1);
+				}
 			}
-		}
+			fresh[w] = 0;
 
-		next_available = active_end = last;
+			pending[w] &= live[w];
+			live[w] &= ~pending[w];
+			n_actives -= popcount(pending[w]);
+		}
 
-		for (auto i = 0ul; i < active_end; i++) {
-			if (i == next_available) {
-				continue;
+		auto w = (active_end + 63) / 64;
+		while (w > 0 && live[w - 1] == 0) {
+			w--;
+		}
+		active_end = w == 0 ? 0 : (w - 1) * 64 + highest_bit(live[w - 1]) + 1;
+
+		// Slots at or above the new active_end are handed out again in order, so they leave the
+		// recycled set and keep their old links, just like the tail of the list always did.
+		for (w = 0; w < N_WORDS; w++) {
+			uint64_t below_end = 0;
+			if ((w + 1) * 64 <= active_end) {
+				below_end = ~uint64_t(0);
+			} else if (w * 64 < active_end) {
+				below_end = (uint64_t(1) << (active_end % 64)) - 1;
 			}
 
-			if (a[i].next_available != i || a[i].t.is_freeable()) {
-				a[i].next_available = next_available;
-				next_available = i;
+			for (auto bits = pending[w] & below_end; bits; bits &= bits - 1) {
+				a[w * 64 + count_trailing_zeros(bits)].next_available = S;
 			}
+
+			reusable[w] = (reusable[w] | pending[w]) & below_end;
+			pending[w] = 0;
 		}
 
-		assert(next_available <= active_end);
+		has_pending = false;
 	}
 
 	[[nodiscard]]
@@ -169,20 +335,68 @@ public:
 	}
 
 	iterator begin() {
-		return iterator(0, *this);
+		return iterator(*this);
 	}
 
 	iterator end() {
-		return iterator(-1, *this);
+		return iterator(S, *this);
+	}
+
+	// Iterates, in slot order, the active objects contained in any of the sets[k] whose bit k is
+	// set in selected.
+	subset_range subset(const index_set* sets, unsigned int selected) {
+		return subset_range(*this, sets, selected);
+	}
+
+	// Saved state of a list. Only the slots below the high-water mark are stored, and the buffer is
+	// reused when the same snapshot_data is saved into again.
+	class snapshot_data {
+		friend class obj_list;
+
+		std::vector<obj_wrap> a;
+		size_t active_end = 0;
+		size_t n_actives = 0;
+		index_set live {}, reusable {}, pending {}, fresh {};
+		bool has_pending = false;
+	};
+
+	void snapshot(snapshot_data& s) const {
+		s.a.assign(a, a + dirty_end);
+		s.active_end = active_end;
+		s.n_actives = n_actives;
+		s.live = live;
+		s.reusable = reusable;
+		s.pending = pending;
+		s.fresh = fresh;
+		s.has_pending = has_pending;
+	}
+
+	void restore(const snapshot_data& s) {
+		auto n = s.a.size();
+		if (n < dirty_end) {
+			memset(static_cast<void*>(a + n), 0, sizeof(obj_wrap) * (dirty_end - n));
+		}
+		std::copy(s.a.begin(), s.a.end(), a);
+
+		active_end = s.active_end;
+		n_actives = s.n_actives;
+		dirty_end = n;
+		live = s.live;
+		reusable = s.reusable;
+		pending = s.pending;
+		fresh = s.fresh;
+		has_pending = s.has_pending;
 	}
 
+	// Only touches the slots that were ever allocated since the last clear.
 	void clear() {
-		next_available = 0;
+		memset(static_cast<void*>(a), 0, sizeof(obj_wrap) * dirty_end);
+		clear_bits((dirty_end + 63) / 64);
+
 		active_end = 0;
 		n_actives = 0;
-		memset(a, 0, sizeof(a));
+		dirty_end = 0;
 	}
 };
 
 };
-
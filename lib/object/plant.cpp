@@ -456,6 +456,7 @@ void plant::to_json(
     writer.Key("ignore_jack_explode");
     writer.Bool(ignore_jack_explode);
 
+#ifndef PVZEMU_LEAN
     writer.Key("explode");
     writer.StartObject();
     writer.Key("from_upper");
@@ -465,6 +466,7 @@ void plant::to_json(
     writer.Key("from_lower");
     writer.Uint(explode.from_lower);
     writer.EndObject();
+#endif
 
     writer.EndObject();
 }
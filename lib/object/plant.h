@@ -200,12 +200,16 @@ public:
     bool ignore_garg_smash;
     bool ignore_jack_explode;
     
+#ifndef PVZEMU_LEAN
+    // jack-in-the-box explosions that hit this plant, recorded for explode_test. Compiled out in
+    // lean builds.
     struct explode_info {
         unsigned int from_upper;
         unsigned int from_same;
         unsigned int from_lower;
     };
     explode_info explode;
+#endif
 
     static const std::array<unsigned int, 49> EFFECT_INTERVAL_TABLE;
     static const std::array<bool, 49> CAN_ATTACK_TABLE;
@@ -42,11 +42,15 @@ scene::scene(const scene& s) :
     type(s.type),
     rng(s.rng),
     zombie_dancing_clock(s.zombie_dancing_clock),
+    next_uuid(s.next_uuid),
     rows(s.rows),
     zombies(s.zombies),
     plants(s.plants),
     griditems(s.griditems),
     projectiles(s.projectiles),
+    zombie_rows(s.zombie_rows),
+    griditem_timers(s.griditem_timers),
+    wave_hp(s.wave_hp),
     spawn(s.spawn),
     sun(s.sun),
     ice_path(s.ice_path),
@@ -60,7 +64,8 @@ scene::scene(const scene& s) :
     disable_garg_throw_imp(s.disable_garg_throw_imp),
     disable_crater(s.disable_crater),
     lock_dx(s.lock_dx),
-    lock_dx_val(s.lock_dx_val)
+    lock_dx_val(s.lock_dx_val),
+    disabled_passes(s.disabled_passes)
 {
     memset(&plant_map, 0, sizeof(plant_map));
 
@@ -79,6 +84,159 @@ scene::scene(const scene& s) :
     }
 }
 
+void scene::set_zombie_row(zombie& z, unsigned int row) {
+    assert(row < zombie_rows.size());
+
+    auto i = static_cast<size_t>(zombies.get_index(z));
+    auto bit = uint64_t(1) << (i % 64);
+
+    for (auto& r : zombie_rows) {
+        r[i / 64] &= ~bit;
+    }
+    zombie_rows[row][i / 64] |= bit;
+
+    z.row = row;
+}
+
+void scene::set_griditem_timer(griditem& item, bool running) {
+    auto i = static_cast<size_t>(griditems.get_index(item));
+    auto bit = uint64_t(1) << (i % 64);
+
+    if (running) {
+        griditem_timers[i / 64] |= bit;
+    } else {
+        griditem_timers[i / 64] &= ~bit;
+    }
+}
+
+void scene::update_wave_hp(zombie& z) {
+    unsigned int hp = 0;
+
+    if (!z.is_dead &&
+        !z.is_hypno &&
+        !z.has_death_status() &&
+        z.type != zombie_type::bungee &&
+        z.master_id == -1 &&
+        z.spawn_wave < wave_hp.size())
+    {
+        hp = z.hp +
+            z.accessory_1.hp +
+            static_cast<unsigned int>(z.accessory_2.hp * 0.2000000029802322) +
+            (z.has_balloon ? 20 : 0);
+    }
+
+    if (z.counted_hp) {
+        wave_hp[z.counted_wave] -= z.counted_hp;
+    }
+
+    z.counted_hp = hp;
+    z.counted_wave = z.spawn_wave;
+
+    if (hp) {
+        wave_hp[z.spawn_wave] += hp;
+    }
+}
+
+void scene::snapshot(snapshot_data& s) const {
+    s.type = type;
+    s.rng = rng;
+    s.zombie_dancing_clock = zombie_dancing_clock;
+    s.next_uuid = next_uuid;
+    s.rows = rows;
+
+    zombies.snapshot(s.zombies);
+    plants.snapshot(s.plants);
+    griditems.snapshot(s.griditems);
+    projectiles.snapshot(s.projectiles);
+
+    s.zombie_rows = zombie_rows;
+    s.griditem_timers = griditem_timers;
+    s.wave_hp = wave_hp;
+
+    auto index_of = [this](const plant* p) {
+        return p ? static_cast<int>(plants.slot_of(*p)) : -1;
+    };
+
+    for (size_t row = 0; row < plant_map.size(); row++) {
+        for (size_t col = 0; col < plant_map[row].size(); col++) {
+            const auto& status = plant_map[row][col];
+            s.plant_map[row][col] = {
+                index_of(status.pumpkin),
+                index_of(status.base),
+                index_of(status.content),
+                index_of(status.coffee_bean)
+            };
+        }
+    }
+
+    s.spawn = spawn;
+    s.sun = sun;
+    s.ice_path = ice_path;
+    s.cards = cards;
+
+    s.is_game_over = is_game_over;
+    s.ignore_game_over = ignore_game_over;
+    s.is_zombie_dance = is_zombie_dance;
+    s.is_future_enabled = is_future_enabled;
+    s.stop_spawn = stop_spawn;
+    s.enable_split_pea_bug = enable_split_pea_bug;
+    s.disable_garg_throw_imp = disable_garg_throw_imp;
+    s.disable_crater = disable_crater;
+    s.lock_dx = lock_dx;
+    s.lock_dx_val = lock_dx_val;
+    s.disabled_passes = disabled_passes;
+}
+
+void scene::restore(const snapshot_data& s) {
+    type = s.type;
+    rng = s.rng;
+    zombie_dancing_clock = s.zombie_dancing_clock;
+    next_uuid = s.next_uuid;
+    rows = s.rows;
+
+    zombies.restore(s.zombies);
+    plants.restore(s.plants);
+    griditems.restore(s.griditems);
+    projectiles.restore(s.projectiles);
+
+    zombie_rows = s.zombie_rows;
+    griditem_timers = s.griditem_timers;
+    wave_hp = s.wave_hp;
+
+    auto plant_at = [this](int i) {
+        return i == -1 ? nullptr : &plants.slot(static_cast<size_t>(i));
+    };
+
+    for (size_t row = 0; row < plant_map.size(); row++) {
+        for (size_t col = 0; col < plant_map[row].size(); col++) {
+            const auto& indices = s.plant_map[row][col];
+            auto& status = plant_map[row][col];
+
+            status.pumpkin = plant_at(indices[0]);
+            status.base = plant_at(indices[1]);
+            status.content = plant_at(indices[2]);
+            status.coffee_bean = plant_at(indices[3]);
+        }
+    }
+
+    spawn = s.spawn;
+    sun = s.sun;
+    ice_path = s.ice_path;
+    cards = s.cards;
+
+    is_game_over = s.is_game_over;
+    ignore_game_over = s.ignore_game_over;
+    is_zombie_dance = s.is_zombie_dance;
+    is_future_enabled = s.is_future_enabled;
+    stop_spawn = s.stop_spawn;
+    enable_split_pea_bug = s.enable_split_pea_bug;
+    disable_garg_throw_imp = s.disable_garg_throw_imp;
+    disable_crater = s.disable_crater;
+    lock_dx = s.lock_dx;
+    lock_dx_val = s.lock_dx_val;
+    disabled_passes = s.disabled_passes;
+}
+
 void scene::to_json(rapidjson::Writer<rapidjson::StringBuffer>& writer) {
     writer.StartObject();
 
@@ -317,9 +475,14 @@ void scene::to_json(rapidjson::Writer<rapidjson::StringBuffer>& writer) {
 }
 
 void scene::reset() {
-    rng = std::mt19937(std::random_device()());
+    reset(static_cast<uint32_t>(rng()));
+}
+
+void scene::reset(uint32_t seed) {
+    rng.seed(seed);
 
     zombie_dancing_clock = rng() % 10000;
+    next_uuid = 0;
     is_zombie_dance = false;
     is_future_enabled = false;
     is_game_over = false;
@@ -330,16 +493,20 @@ void scene::reset() {
     disable_crater = false;
     lock_dx = false;
     lock_dx_val = 0.0f;
+    disabled_passes = 0;
 
     zombies.clear();
     plants.clear();
     griditems.clear();
     projectiles.clear();
 
-    memset(&spawn, 0, sizeof(spawn));
+    memset(&zombie_rows, 0, sizeof(zombie_rows));
+    griditem_timers.fill(0);
+    wave_hp.fill(0);
+
+    // also drops a spawn list left pending by the previous game
+    spawn = spawn_data();
     spawn.total_flags = 1000;
-    spawn.countdown.next_wave = 600;
-    spawn.countdown.next_wave_initial = 600;
 
     memset(&plant_map, 0, sizeof(plant_map));
 
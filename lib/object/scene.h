@@ -1,7 +1,9 @@
 #pragma once
+#include <algorithm>
 #include <array>
 #include <random>
 #include <cassert>
+#include <cstdint>
 
 #include "rapidjson/writer.h"
 #include "rapidjson/stringbuffer.h"
@@ -36,6 +38,16 @@ enum class scene_type {
     moon_night = 0x5,
 };
 
+// Passes of world::update that can be switched off through scene::disabled_passes.
+enum class update_pass : unsigned int {
+    griditem = 0x1,
+    projectile = 0x2,
+    cards = 0x4,
+    sun = 0x8,
+    ice_path = 0x10,
+    endgame = 0x20,
+};
+
 scene_type str_to_scene_type(const std::string& str);
 std::string scene_type_to_str(scene_type scene);
 
@@ -47,6 +59,9 @@ public:
 
     unsigned int zombie_dancing_clock;
 
+    // uuid of the next plant or zombie created in this scene
+    int next_uuid;
+
     unsigned int rows;
 
     obj_list<object::zombie, 1024> zombies;
@@ -54,6 +69,22 @@ public:
     obj_list<object::griditem, 128> griditems;
     obj_list<object::projectile, 1024> projectiles;
 
+    using zombie_index_set = obj_list<object::zombie, 1024>::index_set;
+    using griditem_index_set = obj_list<object::griditem, 128>::index_set;
+
+    // Slot indices of the zombies in each row. Kept in sync by set_zombie_row, which is the only
+    // place zombie::row may be written.
+    std::array<zombie_index_set, 6> zombie_rows;
+
+    // Slot indices of the griditems whose countdown is still running (graves below 100, craters
+    // above 0). griditem::update only visits these; the others never change once settled.
+    griditem_index_set griditem_timers;
+
+    // Remaining hp of the zombies spawned in each wave, as counted by spawn::get_current_hp. Kept
+    // in sync by update_wave_hp, which must follow any change to a zombie's hp, accessories,
+    // balloon, death status, hypnosis, master or spawn wave.
+    std::array<unsigned int, 21> wave_hp;
+
     std::array<std::array<grid_plant_status, 9>, 6> plant_map;
 
     struct spawn_data {
@@ -85,10 +116,23 @@ public:
         std::array<bool, 33> spawn_flags;
         bool is_hugewave_shown;
 
-        spawn_data() {
-            memset(this, 0, sizeof(*this));
-
-            total_flags = 999;
+        // spawn_list is generated on first use (spawn::get_spawn_list) from this copy of the
+        // scene generator, taken where spawn::reset used to generate it.
+        bool is_spawn_list_pending;
+        std::mt19937 spawn_list_rng;
+
+        spawn_data() :
+            spawn_list(),
+            total_flags(999),
+            wave(0),
+            hp(),
+            countdown(),
+            row_random(),
+            spawn_flags(),
+            is_hugewave_shown(false),
+            is_spawn_list_pending(false),
+            spawn_list_rng()
+        {
             countdown.next_wave = 600;
             countdown.next_wave_initial = 600;
         }
@@ -142,11 +186,56 @@ public:
     bool disable_crater;
     bool lock_dx;
     float lock_dx_val;
+    // update_pass bits of the passes world::update skips. Creating a griditem or projectile,
+    // setting a card cooldown, an ice path or the endgame countdown turns the matching pass
+    // back on; the sun pass stays off (skipping it also skips its rng draws).
+    unsigned int disabled_passes;
 /* 可配置部分结束 */
 
-    scene(scene_type t) : type(t),
-        rng(std::random_device()()),
+    // State saved by snapshot(). The object lists only keep their used prefix and plant_map is
+    // kept as plant slot indices (-1 for none), so restoring does not depend on where the
+    // snapshot was taken from.
+    struct snapshot_data {
+        scene_type type;
+        std::mt19937 rng;
+        unsigned int zombie_dancing_clock;
+        int next_uuid;
+        unsigned int rows;
+
+        obj_list<object::zombie, 1024>::snapshot_data zombies;
+        obj_list<object::plant, 512>::snapshot_data plants;
+        obj_list<object::griditem, 128>::snapshot_data griditems;
+        obj_list<object::projectile, 1024>::snapshot_data projectiles;
+
+        std::array<zombie_index_set, 6> zombie_rows;
+        griditem_index_set griditem_timers;
+        std::array<unsigned int, 21> wave_hp;
+        std::array<std::array<std::array<int, 4>, 9>, 6> plant_map;
+
+        spawn_data spawn;
+        sun_data sun;
+        ice_path_data ice_path;
+        std::array<card_data, 10> cards;
+
+        bool is_game_over;
+        bool ignore_game_over;
+        bool is_zombie_dance;
+        bool is_future_enabled;
+        bool stop_spawn;
+        bool enable_split_pea_bug;
+        bool disable_garg_throw_imp;
+        bool disable_crater;
+        bool lock_dx;
+        float lock_dx_val;
+        unsigned int disabled_passes;
+    };
+
+    scene(scene_type t) : scene(t, std::random_device()()) {}
+
+    scene(scene_type t, uint32_t seed) : type(t),
+        rng(seed),
         zombie_dancing_clock(rng() % 10000),
+        next_uuid(0),
         rows(get_max_row()),
         is_game_over(false),
         ignore_game_over(false),
@@ -154,7 +243,16 @@ public:
         is_future_enabled(false),
         stop_spawn(false),
         enable_split_pea_bug(true),
-        disable_garg_throw_imp(false) {}
+        disable_garg_throw_imp(false),
+        disable_crater(false),
+        lock_dx(false),
+        lock_dx_val(0.0f),
+        disabled_passes(0)
+    {
+        memset(&zombie_rows, 0, sizeof(zombie_rows));
+        griditem_timers.fill(0);
+        wave_hp.fill(0);
+    }
 
     scene(const scene& s);
 
@@ -166,14 +264,55 @@ public:
         return (row == 2 || row == 3) && (col >= 0 && col <= 8);
     }
 
+    int get_uuid() {
+        return next_uuid++;
+    }
+
+    bool is_pass_enabled(update_pass pass) const {
+        return !(disabled_passes & static_cast<unsigned int>(pass));
+    }
+
+    void enable_pass(update_pass pass) {
+        disabled_passes &= ~static_cast<unsigned int>(pass);
+    }
+
     unsigned int get_max_row() {
         return type == scene_type::pool || type == scene_type::fog ?  6 : 5;
     }
 
+    void set_zombie_row(object::zombie& z, unsigned int row);
+
+    void update_wave_hp(object::zombie& z);
+
+    void set_griditem_timer(object::griditem& item, bool running);
+
+    auto zombies_in_row(unsigned int row) {
+        assert(row < zombie_rows.size());
+        return zombies.subset(zombie_rows.data(), 1u << row);
+    }
+
+    // rows in [first, last], clamped to the lawn
+    auto zombies_in_rows(int first, int last) {
+        unsigned int selected = 0;
+        for (int row = std::max(first, 0); row <= std::min(last, 5); row++) {
+            selected |= 1u << row;
+        }
+        return zombies.subset(zombie_rows.data(), selected);
+    }
+
     void to_json(rapidjson::Writer<rapidjson::StringBuffer>& writer);
 
+    // Saves into s, reusing its buffers.
+    void snapshot(snapshot_data& s) const;
+
+    void restore(const snapshot_data& s);
+
+    // Reseeds from the scene's own generator, so a scene constructed with a fixed seed replays
+    // the same sequence of resets.
     void reset();
 
+    void reset(uint32_t seed);
+
     void reset(scene_type type) {
         this->type = type;
         rows = get_max_row();
@@ -326,6 +326,7 @@ void zombie::to_json(
     writer.Uint(accessory_2.max_hp);
     writer.EndObject();
 
+#ifndef PVZEMU_LEAN
     writer.Key("attempted_smashes");
     writer.StartArray();
     for (int i = 0; i < attempted_smashes.size; i++) {
@@ -346,6 +347,7 @@ void zombie::to_json(
         writer.Int(hit_by_ash.arr[i]);
     }
     writer.EndArray();
+#endif
 
     writer.Key("master_id");
     if (master_id == -1) {
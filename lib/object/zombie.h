@@ -140,21 +140,8 @@ class scene;
 
 class zombie {
 public:
-    int uuid;
-    struct {
-        int arr[64];
-        int size;
-    } attempted_smashes;
-    struct {
-        int arr[4];
-        int size;
-    } ignored_smashes;
-    struct {
-        int arr[4];
-        int size;
-    } hit_by_ash;
-    zombie_dance_cheat dance_cheat;
-
+    // Fields read or written by zombie_system::update for every zombie on every tick come first,
+    // so that the part of each zombie the tick loop touches spans as few cache lines as possible.
     zombie_type type;
     zombie_status status;
     zombie_action action;
@@ -173,8 +160,18 @@ public:
     const float* _ground;
 
     unsigned int row;
-    int bungee_col;
-    int ladder_col;
+
+    struct {
+        unsigned int butter;
+        unsigned int freeze;
+        unsigned int slow;
+        int action;
+        int dead;
+    } countdown;
+
+    unsigned int time_since_spawn;
+
+    int hp;
 
     struct {
         int x;
@@ -192,20 +189,31 @@ public:
         int height;
     } attack_box;
 
-    struct {
-        unsigned int butter;
-        unsigned int freeze;
-        unsigned int slow;
-        int action;
-        int dead;
-    } countdown;
+    bool is_eating;
+    bool is_dead;
+    bool is_blown;
+    bool is_not_dying;
+    bool is_hypno;
+    bool has_item_or_walk_left;
+    bool is_in_water;
+    bool has_balloon;
+    bool has_eaten_garlic;
+
+    // Everything below is only used by particular zombie types, on damage, or for analysis.
+    int uuid;
+    zombie_dance_cheat dance_cheat;
+
+    int bungee_col;
+    int ladder_col;
 
     unsigned int spawn_wave;
 
+    // This zombie's share of scene::wave_hp and the wave it is counted under.
+    unsigned int counted_hp;
+    unsigned int counted_wave;
+
     unsigned int time_since_ate_garlic;
-    unsigned int time_since_spawn;
 
-    int hp;
     unsigned int max_hp;
 
     struct {
@@ -236,15 +244,21 @@ public:
         unsigned int summon_countdown;
     } catapult_or_jackson;
 
-    bool is_eating;
-    bool is_dead;
-    bool is_blown;
-    bool is_not_dying;
-    bool is_hypno;
-    bool has_item_or_walk_left;
-    bool is_in_water;
-    bool has_balloon;
-    bool has_eaten_garlic;
+#ifndef PVZEMU_LEAN
+    // uuids of the plants involved, recorded for smash_test. Compiled out in lean builds.
+    struct {
+        int arr[64];
+        int size;
+    } attempted_smashes;
+    struct {
+        int arr[4];
+        int size;
+    } ignored_smashes;
+    struct {
+        int arr[4];
+        int size;
+    } hit_by_ash;
+#endif
 
     bool has_reanim(zombie_reanim_name name) const;
 
@@ -1,8 +1,11 @@
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
+#include <pybind11/numpy.h>
 
 #include "world.h"
 #include "learning/observation_factory.h"
+#include "learning/thread_pool.h"
+#include "learning/vector_env.h"
 
 namespace py = pybind11;
 
@@ -13,9 +16,69 @@ PYBIND11_MAKE_OPAQUE(std::vector<int>);
 PYBIND11_MAKE_OPAQUE(std::vector<float>);
 PYBIND11_MAKE_OPAQUE(pvz_emulator::world::batch_action_masks);
 
+namespace {
+
+// Output arrays are written in place, so they must already have the exact dtype, be
+// C-contiguous and have the given shape; pass them with noconvert() so pybind11 does not hand
+// over a converted copy instead.
+template<typename T>
+T *checked_data(py::array_t<T, py::array::c_style>& a, std::initializer_list<size_t> shape) {
+    if (static_cast<size_t>(a.ndim()) != shape.size() ||
+        !std::equal(shape.begin(), shape.end(), a.shape(), [](size_t n, py::ssize_t m) {
+            return static_cast<py::ssize_t>(n) == m;
+        }))
+    {
+        throw py::value_error("array shape does not match the batch");
+    }
+
+    return a.mutable_data();
+}
+
+// Actions for a vector_env step, from any int sequence or array.
+using action_array = py::array_t<int, py::array::c_style | py::array::forcecast>;
+
+std::vector<int> to_actions(const learning::vector_env& env, const action_array& actions) {
+    if (actions.ndim() != 1 || static_cast<size_t>(actions.shape(0)) != env.size()) {
+        throw py::value_error("need one action per world");
+    }
+
+    return std::vector<int>(actions.data(), actions.data() + actions.shape(0));
+}
+
+// NumPy views of a vector_env buffer; they keep the env alive, and their contents change once
+// the buffer is reused two steps later.
+py::tuple buffer_views(learning::vector_env& env, const learning::vector_env::buffer& b) {
+    auto base = py::cast(&env, py::return_value_policy::reference);
+    auto n = static_cast<py::ssize_t>(env.size());
+
+    auto view = [&](const auto& v, py::ssize_t cols) {
+        using T = typename std::decay_t<decltype(v)>::value_type;
+        auto shape = cols ? std::vector<py::ssize_t> {n, cols} : std::vector<py::ssize_t> {n};
+        return py::array_t<T>(shape, v.data(), base);
+    };
+
+    return py::make_tuple(
+        view(b.ob, static_cast<py::ssize_t>(env.row_size())),
+        view(b.masks, static_cast<py::ssize_t>(env.n_masks())),
+        view(b.check_result, 0),
+        view(b.done, 0));
+}
+
+}
+
 PYBIND11_MODULE(pvzemu, m) {
-    py::class_<std::vector<int>>(m, "IntVector")
+    m.def("configure_thread_pool",
+        &learning::thread_pool::configure,
+        py::arg("n_threads"),
+        py::arg("pin") = false);
+
+    // The buffer protocol gives zero-copy views, e.g. np.asarray(v); a view is only valid until
+    // the vector is next resized.
+    py::class_<std::vector<int>>(m, "IntVector", py::buffer_protocol())
         .def(py::init<>())
+        .def_buffer([](std::vector<int>& v) {
+            return py::buffer_info(v.data(), static_cast<py::ssize_t>(v.size()));
+        })
         .def("__getitem__", [](const std::vector<int>& v, std::vector<int>::size_type i) {
             return v[i];
         }).def("__len__", [](const std::vector<int>& v) { return v.size(); })
@@ -23,8 +86,11 @@ PYBIND11_MODULE(pvzemu, m) {
             return py::make_iterator(v.begin(), v.end());
         }, py::keep_alive<0, 1>());
 
-    py::class_<std::vector<float>>(m, "FloatVector")
+    py::class_<std::vector<float>>(m, "FloatVector", py::buffer_protocol())
         .def(py::init<>())
+        .def_buffer([](std::vector<float>& v) {
+            return py::buffer_info(v.data(), static_cast<py::ssize_t>(v.size()));
+        })
         .def("__getitem__", [](
             const std::vector<float>& v,
             std::vector<float>::size_type i)
@@ -48,6 +114,9 @@ PYBIND11_MODULE(pvzemu, m) {
             return py::make_iterator(v.begin(), v.end());
         }, py::keep_alive<0, 1>());
 
+    py::class_<world::snapshot_data>(m, "Snapshot")
+        .def(py::init<>());
+
     py::class_<world>(m, "World")
         .def_readwrite("scene", &world::scene)
         .def_readonly("sun", &world::sun)
@@ -63,16 +132,48 @@ PYBIND11_MODULE(pvzemu, m) {
         .def_readonly("projectile", &world::projectile)
         .def("update", (bool (world::*)(void)) & world::update)
         .def("update", (bool (world::*)(const std::tuple<int, int, int>&)) & world::update)
+        .def("run", [](world& w, unsigned int n) {
+            unsigned int ticks_run;
+            auto stopped = w.run(n, ticks_run);
+            return py::make_tuple(stopped, ticks_run);
+        })
+        .def("run_until", [](world& w, const py::function& pred, unsigned int max_ticks) {
+            unsigned int ticks_run;
+            auto stopped = w.run_until(
+                [&pred](world& w) { return pred(&w).cast<bool>(); }, max_ticks, ticks_run);
+            return py::make_tuple(stopped, ticks_run);
+        })
         .def("get_available_actions", &world::get_available_actions)
-        .def_static("update_all", &world::update_all)
+        .def("get_available_action_bits", &world::get_available_action_bits)
+        .def("get_available_action_bytes", [](const world& w, const world::action_vector& actions) {
+            // one int8 per action plus the no-op, unpacked from the bitmask
+            std::vector<uint64_t> bits;
+            w.get_available_action_bits(actions, bits);
+
+            py::array_t<int8_t> bytes(static_cast<py::ssize_t>(actions.size() + 1));
+            auto data = bytes.mutable_data();
+            for (size_t i = 0; i < actions.size() + 1; i++) {
+                data[i] = static_cast<int8_t>((bits[i / 64] >> (i % 64)) & 1);
+            }
+            return bytes;
+        })
+        .def_static("update_all",
+            &world::update_all,
+            py::call_guard<py::gil_scoped_release>())
+        .def("step", &world::step)
         .def(py::init<scene_type>())
+        .def(py::init<scene_type, uint32_t>())
         .def("select_plants", &world::select_plants)
         .def("plant",
             (bool (world::*)(unsigned int, unsigned int, unsigned int)) & world::plant)
         .def("plant",
             (bool (world::*)(plant_type, unsigned int, unsigned int)) & world::plant)
         .def("check_build", &world::check_build)
+        .def("snapshot", (world::snapshot_data (world::*)(void) const) & world::snapshot)
+        .def("snapshot", (void (world::*)(world::snapshot_data&) const) & world::snapshot)
+        .def("restore", &world::restore)
         .def("reset", (void (world::*)(void)) & world::reset)
+        .def("reset", (void (world::*)(uint32_t)) & world::reset)
         .def("reset", (void (world::*)(scene_type)) & world::reset)
         .def("to_json",[](world& w){
             std::string s;
@@ -102,7 +203,72 @@ PYBIND11_MODULE(pvzemu, m) {
             std::vector<world *> &worlds,
             const world::batch_action_masks& action_masks,
             std::vector<float> &ob
-        )) & learning::observation_factory::create)
+        )) & learning::observation_factory::create,
+            py::call_guard<py::gil_scoped_release>())
+        .def("update_and_create", (void (learning::observation_factory::*)(
+            std::vector<world *> &worlds,
+            const world::action_vector &all_actions,
+            world::action_vector &actions,
+            world::batch_action_masks &action_masks,
+            const world::check_list &build_check_list,
+            std::vector<int> &check_result,
+            std::vector<int> &done,
+            std::vector<float> &ob,
+            unsigned int frames
+        )) & learning::observation_factory::update_and_create,
+            py::call_guard<py::gil_scoped_release>())
+        .def("create_into", [](
+            learning::observation_factory& f,
+            std::vector<world *> &worlds,
+            py::array_t<int8_t, py::array::c_style> masks,
+            py::array_t<float, py::array::c_style> ob)
+        {
+            auto n_masks = masks.ndim() == 2 ? static_cast<size_t>(masks.shape(1)) : 0;
+            auto masks_data = checked_data(masks, {worlds.size(), n_masks});
+            auto ob_data = checked_data(ob, {worlds.size(), f.single_size + n_masks});
+
+            py::gil_scoped_release release;
+            f.create(worlds, masks_data, n_masks, ob_data);
+        },
+            py::arg("worlds"),
+            py::arg("masks").noconvert(),
+            py::arg("ob").noconvert())
+        .def("update_and_create_into", [](
+            learning::observation_factory& f,
+            std::vector<world *> &worlds,
+            const world::action_vector &all_actions,
+            const world::action_vector &actions,
+            const world::check_list &build_check_list,
+            py::array_t<int8_t, py::array::c_style> masks,
+            py::array_t<int32_t, py::array::c_style> check_result,
+            py::array_t<int32_t, py::array::c_style> done,
+            py::array_t<float, py::array::c_style> ob,
+            unsigned int frames)
+        {
+            auto n = worlds.size();
+            auto n_masks = all_actions.size() + 1;
+            if (actions.size() != n) {
+                throw py::value_error("need one action per world");
+            }
+
+            auto masks_data = checked_data(masks, {n, n_masks});
+            auto check_result_data = checked_data(check_result, {n});
+            auto done_data = checked_data(done, {n});
+            auto ob_data = checked_data(ob, {n, f.single_size + n_masks});
+
+            py::gil_scoped_release release;
+            f.update_and_create(worlds, all_actions, actions, build_check_list,
+                masks_data, check_result_data, done_data, ob_data, frames);
+        },
+            py::arg("worlds"),
+            py::arg("all_actions"),
+            py::arg("actions"),
+            py::arg("build_check_list"),
+            py::arg("masks").noconvert(),
+            py::arg("check_result").noconvert(),
+            py::arg("done").noconvert(),
+            py::arg("ob").noconvert(),
+            py::arg("frames") = 1)
         .def_readonly("num_zombies", &learning::observation_factory::num_zombies)
         .def_readonly("num_plants", &learning::observation_factory::num_plants)
         .def_readonly("num_projectiles", &learning::observation_factory::num_projectiles)
@@ -118,6 +284,14 @@ PYBIND11_MODULE(pvzemu, m) {
         .value("roof", scene_type::roof)
         .value("moon_night", scene_type::moon_night);
 
+    py::enum_<update_pass>(m, "UpdatePass", py::arithmetic())
+        .value("griditem", update_pass::griditem)
+        .value("projectile", update_pass::projectile)
+        .value("cards", update_pass::cards)
+        .value("sun", update_pass::sun)
+        .value("ice_path", update_pass::ice_path)
+        .value("endgame", update_pass::endgame);
+
     py::enum_<plant_type>(m, "PlantType")
         .value("none", plant_type::none)
         .value("pea_shooter", plant_type::pea_shooter)
@@ -212,6 +386,7 @@ PYBIND11_MODULE(pvzemu, m) {
     py::class_<scene>(m, "Scene")
         .def_readonly("type", &scene::type)
         .def_readonly("zombie_dancing_clock", &scene::zombie_dancing_clock)
+        .def_readonly("next_uuid", &scene::next_uuid)
         .def_readonly("rows", &scene::rows)
         .def_readonly("zombies", &scene::zombies)
         .def_readonly("plants", &scene::plants)
@@ -227,10 +402,13 @@ PYBIND11_MODULE(pvzemu, m) {
         .def_readwrite("is_future_enabled", &scene::is_future_enabled)
         .def_readwrite("stop_spawn", &scene::stop_spawn)
         .def_readwrite("enable_split_pea_bug", &scene::enable_split_pea_bug)
+        .def_readwrite("disabled_passes", &scene::disabled_passes)
         .def(py::init<scene_type>())
+        .def(py::init<scene_type, uint32_t>())
         .def("is_water_grid", &scene::is_water_grid)
         .def("get_max_row", &scene::get_max_row)
         .def("reset", (void (scene::*)(void)) & scene::reset)
+        .def("reset", (void (scene::*)(uint32_t)) & scene::reset)
         .def("reset", (void (scene::*)(scene_type)) & scene::reset);
 
     py::class_<decltype(scene::zombies)>(m, "ZombieList")
@@ -263,7 +441,6 @@ PYBIND11_MODULE(pvzemu, m) {
         .def_readonly("cold_down", &scene::card_data::cold_down);
 
     py::class_<scene::spawn_data>(m, "SpawnData")
-        .def_readonly("spawn_list", &scene::spawn_data::spawn_list)
         .def_readonly("total_flags", &scene::spawn_data::total_flags)
         .def_readonly("wave", &scene::spawn_data::wave)
         .def_readonly("hp", &scene::spawn_data::hp)
@@ -787,6 +964,7 @@ PYBIND11_MODULE(pvzemu, m) {
     py::class_<spawn>(m, "Spawn")
         .def(py::init<scene&>())
         .def("get_current_hp", &spawn::get_current_hp)
+        .def("get_spawn_list", &spawn::get_spawn_list)
         .def("reset", &spawn::reset)
         .def("update", &spawn::update);
 
@@ -816,7 +994,8 @@ PYBIND11_MODULE(pvzemu, m) {
             py::arg("type"),
             py::arg("row"),
             py::arg("col"),
-            py::arg("imitater_target") = plant_type::none)
+            py::arg("imitater_target") = plant_type::none,
+            py::arg("skip_plant_map") = false)
         .def("destroy", &plant_factory::destroy);
 
     py::class_<zombie_factory>(m, "ZombieFactory")
@@ -852,4 +1031,64 @@ PYBIND11_MODULE(pvzemu, m) {
         .value("jump", zombie_attack_type::jump)
         .value("place_ladder", zombie_attack_type::place_ladder);
 
+    py::class_<learning::vector_env>(m, "VectorEnv")
+        .def(py::init<
+            scene_type,
+            unsigned int,
+            const world::action_vector&,
+            unsigned int,
+            unsigned int,
+            unsigned int,
+            unsigned int,
+            uint32_t,
+            const std::vector<plant_type>&,
+            plant_type,
+            const world::check_list&,
+            unsigned int>(),
+            py::arg("type"),
+            py::arg("n"),
+            py::arg("all_actions"),
+            py::arg("num_zombies"),
+            py::arg("num_plants"),
+            py::arg("num_projectiles"),
+            py::arg("num_griditems"),
+            py::arg("seed") = 0,
+            py::arg("cards") = std::vector<plant_type>(),
+            py::arg("imitater_type") = plant_type::none,
+            py::arg("build_check_list") = world::check_list(),
+            py::arg("frames") = 1)
+        .def("__len__", &learning::vector_env::size)
+        .def("get_world", &learning::vector_env::get_world, py::return_value_policy::reference_internal)
+        .def_property_readonly("row_size", &learning::vector_env::row_size)
+        .def_property_readonly("n_masks", &learning::vector_env::n_masks)
+        // reset / step_wait / step return (ob, masks, check_result, done) as NumPy views
+        .def("reset", [](learning::vector_env& env) {
+            const learning::vector_env::buffer *b;
+            {
+                py::gil_scoped_release release;
+                b = &env.reset();
+            }
+            return buffer_views(env, *b);
+        })
+        .def("step_async", [](learning::vector_env& env, const action_array& actions) {
+            env.step_async(to_actions(env, actions));
+        }, py::arg("actions"))
+        .def("step_wait", [](learning::vector_env& env) {
+            const learning::vector_env::buffer *b;
+            {
+                py::gil_scoped_release release;
+                b = &env.step_wait();
+            }
+            return buffer_views(env, *b);
+        })
+        .def("step", [](learning::vector_env& env, const action_array& actions) {
+            auto v = to_actions(env, actions);
+
+            const learning::vector_env::buffer *b;
+            {
+                py::gil_scoped_release release;
+                b = &env.step(v);
+            }
+            return buffer_views(env, *b);
+        }, py::arg("actions"));
 }
@@ -25,7 +25,7 @@ class BuildExt(build_ext):
         if sys.platform == "darwin":
             opts.append("-stdlib=libc++")
 
-        ext.define_macros = [("NDEBUG", "1")]
+        ext.define_macros = [("NDEBUG", "1"), ("PVZEMU_LEAN", "1")]
         ext.extra_compile_args = opts
 
         build_ext.build_extension(self, ext)
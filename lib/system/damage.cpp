@@ -242,6 +242,7 @@ void damage::destroy_accessory_2(zombie& z) {
     }
 
     z.accessory_2.type = zombie_accessories_type_2::none;
+    scene.update_wave_hp(z);
 }
 
 void damage::take_body(zombie& z, unsigned int damage, unsigned int flags) {
@@ -334,6 +335,7 @@ void damage::take_ash_attack(zombie& z) {
             z.reanim.fps = 0;
             z.status = zombie_status::dying_from_instant_kill;
             z.countdown.action = 300;
+            scene.update_wave_hp(z);
 
             return;
         }
@@ -419,8 +421,8 @@ void damage::activate_plant(object::plant& p) {
         return;
 
     case plant_type::jalapeno:    
-        for (auto& z : scene.zombies) {
-            if (z.row != p.row || !can_be_attacked(z, flags)) {
+        for (auto& z : scene.zombies_in_row(p.row)) {
+            if (!can_be_attacked(z, flags)) {
                 continue;
             }
 
@@ -431,9 +433,11 @@ void damage::activate_plant(object::plant& p) {
             }
 
             take_ash_attack(z);
+#ifndef PVZEMU_LEAN
             if (z.hit_by_ash.size < 4) {
                 z.hit_by_ash.arr[z.hit_by_ash.size++] = p.uuid;
             }
+#endif
         }
 
         for (auto& item : scene.griditems) {
@@ -512,9 +516,11 @@ void damage::range_attack(object::plant& p, unsigned int flags) {
 
     auto pf = p.get_attack_flags(false);
 
-    for (auto& z : scene.zombies) {
-        auto diff = abs(static_cast<int>(z.row) - static_cast<int>(p.row));
-        if (diff > 1 || !can_be_attacked(z, pf)) {
+    auto row = static_cast<int>(p.row);
+
+    for (auto& z : scene.zombies_in_rows(row - 1, row + 1)) {
+        auto diff = abs(static_cast<int>(z.row) - row);
+        if (!can_be_attacked(z, pf)) {
             continue;
         }
 
@@ -552,9 +558,9 @@ void damage::take_instant_kill(
     int grid_radius,
     bool is_ash_attack,
     unsigned char flags,
-    int from_plant)
+    [[maybe_unused]] int from_plant)
 {
-    for (auto& z : scene.zombies) {
+    for (auto& z : scene.zombies_in_rows(row - grid_radius, row + grid_radius)) {
         if (!can_be_attacked(z, flags)) {
             continue;
         }
@@ -562,13 +568,14 @@ void damage::take_instant_kill(
         rect rect;
         z.get_hit_box(rect);
 
-        if (abs(static_cast<int>(z.row) - row) <= grid_radius &&
-            rect.is_overlap_with_circle(x, y, radius))
+        if (rect.is_overlap_with_circle(x, y, radius))
         {
             if (is_ash_attack) {
+#ifndef PVZEMU_LEAN
                 if (from_plant != -1 && z.hit_by_ash.size < 4) {
                     z.hit_by_ash.arr[z.hit_by_ash.size++] = from_plant;
                 }
+#endif
                 take_ash_attack(z);
             } else {
                 take(z,
@@ -666,6 +673,8 @@ void damage::take(object::zombie& z, unsigned int damage, unsigned int flags) {
     if (d > 0) {
         take_body(z, d, flags);
     }
+
+    scene.update_wave_hp(z);
 }
 
 }
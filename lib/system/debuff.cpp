@@ -27,9 +27,11 @@ void debuff::set_butter(object::zombie& z) {
         if (z.master_id != -1) {
             if (auto master = scene.zombies.get(z.master_id)) {
                 master->master_id = -1;
+                scene.update_wave_hp(*master);
             }
 
             z.master_id = -1;
+            scene.update_wave_hp(z);
         }
 
         if (z.type == zombie_type::pogo) {
@@ -1,4 +1,5 @@
 #pragma once
+#include <limits>
 #include "object/scene.h"
 
 namespace pvz_emulator::system {
@@ -12,6 +13,18 @@ public:
     bool update() {
         return data.countdown.endgame > 0 && --data.countdown.endgame == 0;
     }
+
+    unsigned int idle_ticks() const {
+        return data.countdown.endgame > 0 ?
+            data.countdown.endgame - 1 :
+            std::numeric_limits<unsigned int>::max();
+    }
+
+    void skip(unsigned int n) {
+        if (data.countdown.endgame > 0) {
+            data.countdown.endgame -= n;
+        }
+    }
 };
 
 }
@@ -15,21 +15,30 @@ public:
     griditem(object::scene& s): scene(s), griditem_factory(s) {}
 
     void update() {
-        for (auto& item : scene.griditems) {
+        for (auto& item : scene.griditems.subset(&scene.griditem_timers, 1)) {
             switch (item.type) {
             case griditem_type::grave:
                 if (item.countdown < 100) {
                     item.countdown++;
                 }
+
+                if (item.countdown >= 100) {
+                    scene.set_griditem_timer(item, false);
+                }
                 break;
 
             case griditem_type::crater:
                 if (item.countdown > 0 && --item.countdown == 0) {
                     griditem_factory.destroy(item);
                 }
+
+                if (item.countdown <= 0) {
+                    scene.set_griditem_timer(item, false);
+                }
                 break;
 
             default:
+                scene.set_griditem_timer(item, false);
                 break;
             }
         }
@@ -10,6 +10,7 @@ griditem& griditem_factory::create(
     unsigned int col)
 {
     auto& item = scene.griditems.alloc();
+    scene.enable_pass(update_pass::griditem);
 
     item.type = type;
     item.col = col;
@@ -39,6 +40,8 @@ griditem& griditem_factory::create(
         break;
     }
 
+    scene.set_griditem_timer(item, type != griditem_type::ladder);
+
     return item;
 }
 
@@ -19,6 +19,7 @@ public:
 
     void destroy(object::griditem& item) {
         item.is_disappeared = true;
+        scene.griditems.release(item);
     }
 };
 
@@ -17,6 +17,17 @@ public:
             }
         }
     }
+
+    void skip(unsigned int n) {
+        for (auto i = 0u; i < scene.rows; i++) {
+            if (data.countdown[i] > n) {
+                data.countdown[i] -= n;
+            } else if (data.countdown[i] > 0) {
+                data.countdown[i] = 0;
+                data.x[i] = 800;
+            }
+        }
+    }
 };
 
 }
@@ -111,6 +111,7 @@ bool plant_magnetshroom::attack_zombie(plant& p) {
     {
         target->accessory_1.type = zombie_accessories_type_1::none;
         target->accessory_1.hp = 0;
+        scene.update_wave_hp(*target);
     } else if (target->accessory_2.type == zombie_accessories_type_2::screen_door ||
         target->accessory_2.type == zombie_accessories_type_2::ladder) {
         damage(scene).destroy_accessory_2(*target);
@@ -202,13 +203,12 @@ void plant_scaredyshroom::update(plant & p) {
     }
 
     bool found_scared = false;
-    for (auto& z : scene.zombies) {
-        auto diff = abs(static_cast<int>(p.row) - static_cast<int>(z.row));
+    auto row = static_cast<int>(p.row);
 
+    for (auto& z : scene.zombies_in_rows(row - 1, row + 1)) {
         if (!z.is_hypno &&
             !z.is_dead &&
-            !z.has_death_status() &&
-            diff <= 1)
+            !z.has_death_status())
         {
             rect zr;
             z.get_hit_box(zr);
@@ -17,7 +17,7 @@ void plant_base::init(
     int col,
     plant_type imitater_target)
 {
-    p.uuid = get_uuid();
+    p.uuid = scene.get_uuid();
     p.type = type;
     p.imitater_target = imitater_target;
 
@@ -62,7 +62,9 @@ void plant_base::init(
     p.ignore_garg_smash = false;
     p.ignore_jack_explode = false;
 
+#ifndef PVZEMU_LEAN
     p.explode = {0, 0, 0};
+#endif
 
     p.threepeater_time_since_first_shot = 0;
 
@@ -119,7 +121,17 @@ zombie* plant_base::find_target(plant& p, unsigned int row, bool is_alt_attack)
     double weight = 0;
     zombie* result = nullptr;
 
-    for (auto& z : scene.zombies) {
+    int first_row = static_cast<int>(row);
+    int last_row = static_cast<int>(row);
+    if (p.type == plant_type::gloomshroom) {
+        first_row--;
+        last_row++;
+    } else if (p.type == plant_type::cattail) {
+        first_row = 0;
+        last_row = 5;
+    }
+
+    for (auto& z : scene.zombies_in_rows(first_row, last_row)) {
         if ((!z.is_not_dying || is_target_of_kelp(scene, z)) &&
             (p.type == plant_type::potato_mine ||
                 p.type == plant_type::chomper ||
@@ -131,19 +131,52 @@ unsigned int plant_factory::get_cost(object::plant_type type) const {
     }
 }
 
+void plant_factory::get_griditem_cover(griditem_cover& cover) const {
+    for (auto& row : cover) {
+        row.fill(0);
+    }
+
+    for (auto& item : scene.griditems) {
+        if (item.row >= cover.size() || item.col >= cover[0].size()) {
+            continue;
+        }
+
+        if (item.type == griditem_type::grave) {
+            cover[item.row][item.col] |= GRAVE;
+        } else if (item.type == griditem_type::crater) {
+            cover[item.row][item.col] |= CRATER;
+        }
+    }
+}
+
 bool plant_factory::can_plant(
     unsigned int row,
     unsigned int col,
     plant_type type,
     plant_type imitater_type) const
 {
-    if (!is_pos_valid(row, col) || !is_not_covered_by_ice_path(row, col)) {
+    if (!is_pos_valid(row, col)) {
         return false;
     }
 
     bool has_grave, has_crater;
     is_covered_by_griditem(row, col, has_grave, has_crater);
 
+    return can_plant_on(row, col, type, imitater_type, has_grave, has_crater);
+}
+
+bool plant_factory::can_plant_on(
+    unsigned int row,
+    unsigned int col,
+    plant_type type,
+    plant_type imitater_type,
+    bool has_grave,
+    bool has_crater) const
+{
+    if (!is_pos_valid(row, col) || !is_not_covered_by_ice_path(row, col)) {
+        return false;
+    }
+
     if (has_crater) {
         return false;
     }
@@ -548,12 +581,14 @@ plant* plant_factory::plant(
     }
 
     scene.cards[i].cold_down = plant::CD_TABLE[static_cast<int>(target_type)];
+    scene.enable_pass(update_pass::cards);
 
     return p;
 }
 
 void plant_factory::destroy(object::plant& p) {
     p.is_dead = true;
+    scene.plants.release(p);
 
     if (p.type == plant_type::tangle_kelp && p.target != -1) {
         if (auto z = scene.zombies.get(p.target)) {
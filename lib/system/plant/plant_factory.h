@@ -30,12 +30,29 @@ class plant_factory {
     unsigned int get_cost(object::plant_type type) const;
 
 public:
+    // Per-cell GRAVE / CRATER flags.
+    using griditem_cover = std::array<std::array<uint8_t, 9>, 6>;
+    static const uint8_t GRAVE = 1;
+    static const uint8_t CRATER = 2;
+
+    void get_griditem_cover(griditem_cover& cover) const;
+
     bool can_plant(
         unsigned int row,
         unsigned int col,
         object::plant_type type,
         object::plant_type imitater_type = object::plant_type::none) const;
 
+    // can_plant with the griditem lookup done by the caller, for checking many cards or cells
+    // after a single pass over scene.griditems.
+    bool can_plant_on(
+        unsigned int row,
+        unsigned int col,
+        object::plant_type type,
+        object::plant_type imitater_type,
+        bool has_grave,
+        bool has_crater) const;
+
     object::plant* plant(
         unsigned int i,
         unsigned int row,
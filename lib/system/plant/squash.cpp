@@ -17,8 +17,8 @@ void plant_squash::kill(plant& p) {
 
     damage damage(scene);
 
-    for (auto& z : scene.zombies) {
-        if (!damage.can_be_attacked(z, flags) || z.row != p.row) {
+    for (auto& z : scene.zombies_in_row(p.row)) {
+        if (!damage.can_be_attacked(z, flags)) {
             continue;
         }
 
@@ -42,9 +42,8 @@ zombie* plant_squash::find_target(plant& p) {
     int min_d = 0;
     zombie* target = nullptr;
 
-    for (auto &z : scene.zombies) {
-        if (z.row == p.row &&
-            z.is_not_dying &&
+    for (auto &z : scene.zombies_in_row(p.row)) {
+        if (z.is_not_dying &&
             !is_target_of_kelp(scene, z) &&
             damage(scene).can_be_attacked(z, p.get_attack_flags(false)))
         {
@@ -9,6 +9,7 @@ using namespace pvz_emulator::object;
 projectile&
 projectile_factory::alloc_and_init(projectile_type type, int row, int x, int y) {
     auto& p = scene.projectiles.alloc();
+    scene.enable_pass(update_pass::projectile);
 
     p.from_plant = 0;
     p.type = type;
@@ -23,6 +23,7 @@ public:
     void destroy(object::projectile& proj) {
         assert(!proj.is_disappeared);
         proj.is_disappeared = true;
+        scene.projectiles.release(proj);
     }
 
     void create(object::projectile_type type, object::zombie& z, object::plant* p);
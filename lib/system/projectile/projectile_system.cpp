@@ -47,9 +47,8 @@ zombie* projectile_system::find_zombie_target(projectile& proj) {
     int min_x;
     zombie* target = nullptr;
 
-    for (auto& z : scene.zombies) {
-        if (z.row == proj.row &&
-            damage.can_be_attacked(z, proj.flags) &&
+    for (auto& z : scene.zombies_in_row(proj.row)) {
+        if (damage.can_be_attacked(z, proj.flags) &&
             (z.status != zombie_status::snorkel_swim || proj.dy1 > 45) &&
             (proj.type != projectile_type::star ||
                 proj.time_since_created >= 25 ||
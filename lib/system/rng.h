@@ -5,6 +5,58 @@
 
 namespace pvz_emulator::system {
 
+// Samples from a fixed set of weights without rebuilding the distribution on every draw. Each
+// draw consumes the generator exactly like rng::random_weighted_sample over the same weights.
+class weighted_sampler {
+	std::discrete_distribution<> d;
+
+public:
+	weighted_sampler() = default;
+
+	template<typename It>
+	weighted_sampler(It first, It last) : d(first, last) {}
+
+	template<typename A>
+	explicit weighted_sampler(const A& v) : weighted_sampler(v.begin(), v.end()) {}
+
+	size_t operator()(std::mt19937& g) {
+		return static_cast<size_t>(d(g));
+	}
+
+	// Generator outputs consumed by one draw from a sampler with at least two weights. The
+	// count does not depend on the weights, but may differ between standard libraries.
+	static size_t n_draws() {
+		static const size_t n = [] {
+			struct counting_engine {
+				using result_type = std::mt19937::result_type;
+
+				std::mt19937 g;
+				size_t n = 0;
+
+				static constexpr result_type min() {
+					return std::mt19937::min();
+				}
+
+				static constexpr result_type max() {
+					return std::mt19937::max();
+				}
+
+				result_type operator()() {
+					n++;
+					return g();
+				}
+			} e;
+
+			std::discrete_distribution<> d({1, 1});
+			d(e);
+
+			return e.n;
+		}();
+
+		return n;
+	}
+};
+
 class rng {
 	object::scene& scene;
 
@@ -17,8 +69,11 @@ public:
 
 	template<typename A>
 	size_t random_weighted_sample(const A& v) {
-		std::discrete_distribution<> d(v.begin(), v.end());
-		return d(scene.rng);
+		return weighted_sampler(v)(scene.rng);
+	}
+
+	size_t random_weighted_sample(weighted_sampler& s) {
+		return s(scene.rng);
 	}
 
 	float randfloat(double a, double b) {
@@ -2,6 +2,7 @@
 #include <array>
 #include <vector>
 #include <algorithm>
+#include <limits>
 #include <utility>
 
 #include "spawn.h"
@@ -143,7 +144,7 @@ zombie_type spawn::gen_lurking_zombie_type() {
 	return LURKING_TYPES[rng.random_weighted_sample(weight)];
 }
 
-void spawn::gen_spawn_list() {
+void spawn::gen_spawn_list(std::mt19937& g) {
 	memset(curr_spawn_count, 0, sizeof(curr_spawn_count));
 	memset(total_spawn_count, 0, sizeof(total_spawn_count));
 
@@ -160,20 +161,27 @@ void spawn::gen_spawn_list() {
 		}
 
 
-        std::vector<zombie_type> types;
-        std::vector<unsigned int> weights;
+        std::array<zombie_type, 33> types;
+        std::array<unsigned int, 33> weights;
+        size_t n_types = 0;
 
         for (int t = 0; t < static_cast<int>(zombie_type::giga_gargantuar); t++) {
             if (!can_spawn(static_cast<zombie_type>(t), wave)) {
                 continue;
             }
 
-            types.push_back(static_cast<zombie_type>(t));
-            weights.push_back(get_spawn_weight(static_cast<zombie_type>(t)));
+            types[n_types] = static_cast<zombie_type>(t);
+            weights[n_types++] = get_spawn_weight(static_cast<zombie_type>(t));
         }
 
+        // reset() counts on every draw here consuming the generator
+        assert(n_types >= 2);
+
+        // the candidates are fixed for the whole wave, so the distribution is built once
+        weighted_sampler sampler(weights.begin(), weights.begin() + n_types);
+
 		for (; i < MAX_ZOMBIES; i++) {
-			spawn_list_append(wave, i, types[rng.random_weighted_sample(weights)]);
+			spawn_list_append(wave, i, types[sampler(g)]);
 		}
 	}
 }
@@ -347,6 +355,18 @@ void spawn::hugewave_warn_update() {
 }
 
 unsigned int spawn::get_current_hp() {
+	auto i = data.wave - 1;
+
+	if (i >= scene.wave_hp.size()) {
+		return scan_current_hp();
+	}
+
+	assert(scene.wave_hp[i] == scan_current_hp());
+
+	return scene.wave_hp[i];
+}
+
+unsigned int spawn::scan_current_hp() {
 	unsigned int hp = 0;
 
 	for (auto& z : scene.zombies) {
@@ -374,6 +394,7 @@ void spawn::next_spawn_countdown_update() {
 	if (data.wave == MAX_WAVES) {
 		if (data.countdown.next_wave == 0) {
 			data.countdown.endgame = 500;
+			scene.enable_pass(update_pass::endgame);
 			for (auto& t : scene.ice_path.countdown) {
 				t = std::min(t, 500u);
 			}
@@ -404,8 +425,9 @@ void spawn::next_spawn_countdown_update() {
 		night_grave_spawn();
 	}
 
+	auto& spawn_list = get_spawn_list();
 	for (int i = 0; i < 50; i++) {
-		zombie_factory.create(data.spawn_list[data.wave][i]);
+		zombie_factory.create(spawn_list[data.wave][i]);
 	}
 	assert(scene.zombies.size() >= 50);
 
@@ -446,6 +468,49 @@ void spawn::update() {
 	}
 }
 
+unsigned int spawn::idle_ticks() {
+	if (data.countdown.hugewave_fade > 0) {
+		return 0;
+	}
+
+	auto n = std::numeric_limits<unsigned int>::max();
+
+	if (data.countdown.lurking_squad > 0) {
+		n = data.countdown.lurking_squad - 1;
+	}
+
+	auto next_wave = data.countdown.next_wave;
+
+	if (data.wave == MAX_WAVES) {
+		// wraps around from 0, like next_spawn_countdown_update
+		return std::min(n, next_wave - 1);
+	}
+
+	// stop before the countdown reaches 5 (huge wave warning) or 0 (next wave)
+	if (next_wave <= 6 || next_wave > data.countdown.next_wave_initial) {
+		return 0;
+	}
+	n = std::min(n, next_wave - 6);
+
+	// with no zombies left the hp check always passes, so the countdown is cut to 200 as soon
+	// as more than 400 ticks have passed
+	auto elapsed = data.countdown.next_wave_initial - next_wave;
+	unsigned int until_cut = elapsed >= 400 ? 1 : 401 - elapsed;
+	if (next_wave > until_cut + 200) {
+		n = std::min(n, until_cut - 1);
+	}
+
+	return n;
+}
+
+void spawn::skip(unsigned int n) {
+	if (data.countdown.lurking_squad > 0) {
+		data.countdown.lurking_squad -= n;
+	}
+
+	data.countdown.next_wave -= n;
+}
+
 void spawn::reset() {
     data.wave = 0;
 	data.hp = { 0 };
@@ -458,7 +523,27 @@ void spawn::reset() {
 	data.total_flags++;
 
     gen_spawn_flags();
-    gen_spawn_list();
+
+	// The list is only generated when first read, which many callers (stop_spawn, short
+	// episodes) never do. The generator is saved and then advanced past the draws
+	// gen_spawn_list would have made, so everything after reset still sees the same sequence.
+	data.spawn_list_rng = scene.rng;
+	data.is_spawn_list_pending = true;
+
+	unsigned long long n_samples = 0;
+	for (unsigned int wave = 0; wave < MAX_WAVES; wave++) {
+		n_samples += MAX_ZOMBIES - (is_wave_9_or_19(wave) ? N_HUGEWAVE_SQUAD + 1 : 0);
+	}
+	scene.rng.discard(n_samples * weighted_sampler::n_draws());
+}
+
+const std::array<std::array<zombie_type, 50>, 20>& spawn::get_spawn_list() {
+	if (data.is_spawn_list_pending) {
+		gen_spawn_list(data.spawn_list_rng);
+		data.is_spawn_list_pending = false;
+	}
+
+	return data.spawn_list;
 }
 
 };
@@ -14,18 +14,31 @@ using namespace ::pvz_emulator::object;
 
 class spawn {
 private:
-    void gen_spawn_list();
+    void gen_spawn_list(std::mt19937& g);
     void gen_spawn_flags();
 
+    // get_current_hp by walking every zombie; used where scene::wave_hp has no entry and to
+    // check it in debug builds.
+    unsigned int scan_current_hp();
+
 public:
     spawn(object::scene& s);
 
     unsigned int get_current_hp();
 
+    // Generates the spawn list left pending by reset() if it has not been generated yet.
+    const std::array<std::array<zombie_type, 50>, 20>& get_spawn_list();
+
     void reset();
 
     void update();
 
+    // Ticks update() can be skipped for while there are no zombies: no wave, lurker or huge
+    // wave warning is due within them.
+    unsigned int idle_ticks();
+
+    void skip(unsigned int n);
+
 private:
     static const unsigned int MAX_WAVES;
     static const unsigned int MAX_ZOMBIES;
@@ -13,10 +13,7 @@ unsigned int sun::gen_nature_sun_countdown() {
 }
 
 void sun::update() {
-    if (scene.type != scene_type::pool &&
-        scene.type != scene_type::day &&
-        scene.type != scene_type::roof)
-    {
+    if (!has_natural_sun()) {
         return;
     }
 
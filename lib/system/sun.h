@@ -1,5 +1,6 @@
 #pragma once
 #include <algorithm>
+#include <limits>
 #include "object/scene.h"
 #include "rng.h"
 
@@ -13,6 +14,12 @@ class sun {
     system::rng rng;
 
     unsigned int gen_nature_sun_countdown();
+
+    bool has_natural_sun() const {
+        return scene.type == object::scene_type::pool ||
+            scene.type == object::scene_type::day ||
+            scene.type == object::scene_type::roof;
+    }
 public:
     void add_sun(unsigned int sun) {
         scene.sun.sun = std::min(MAX_SUN, scene.sun.sun + sun);
@@ -23,6 +30,20 @@ public:
     }
 
     void update();
+
+    // Ticks update() can be skipped for before the next natural sun. The countdown wraps
+    // around from 0, like update() does.
+    unsigned int idle_ticks() const {
+        return has_natural_sun() ?
+            data.natural_sun_countdown - 1 :
+            std::numeric_limits<unsigned int>::max();
+    }
+
+    void skip(unsigned int n) {
+        if (has_natural_sun()) {
+            data.natural_sun_countdown -= n;
+        }
+    }
 };
 
 }
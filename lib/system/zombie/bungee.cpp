@@ -91,7 +91,7 @@ void zombie_bungee::select_target(zombie &z) {
 
     auto& t = targets[rng.random_weighted_sample(weights)];
 
-    z.row = std::get<0>(t);
+    scene.set_zombie_row(z, std::get<0>(t));
     z.bungee_col = std::get<1>(t);
 
     z.x = static_cast<float>(80 * z.bungee_col + 40);
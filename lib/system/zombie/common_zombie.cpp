@@ -8,10 +8,12 @@ namespace pvz_emulator::system {
 using namespace pvz_emulator::object;
 
 void zombie_base::init(object::zombie &z, zombie_type type, unsigned int row) {
-    z.uuid = get_uuid();
+    z.uuid = scene.get_uuid();
+#ifndef PVZEMU_LEAN
     z.attempted_smashes.size = 0;
     z.ignored_smashes.size = 0;
     z.hit_by_ash.size = 0;
+#endif
     z.dance_cheat = zombie_dance_cheat::none;
 
     z.type = type;
@@ -19,8 +21,9 @@ void zombie_base::init(object::zombie &z, zombie_type type, unsigned int row) {
     z.status = zombie_status::walking;
     z.action = zombie_action::none;
 
-    z.row = row;
+    scene.set_zombie_row(z, row);
     z.spawn_wave = scene.spawn.wave;
+    z.counted_hp = 0;
 
     z.hp = 270;
 
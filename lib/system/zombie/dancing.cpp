@@ -91,7 +91,7 @@ void zombie_dancing::create_backup_dancers(zombie& z) {
         auto& backup = zombie_factory(scene).create(zombie_type::backup_dancer);
         backup.spawn_wave = z.spawn_wave;
 
-        backup.row = row;
+        scene.set_zombie_row(backup, row);
 
         backup.x = x;
         backup.y = zombie_init_y(scene.type, z, row);
@@ -109,6 +109,7 @@ void zombie_dancing::create_backup_dancers(zombie& z) {
         reanim.set_fps(backup, 0);
 
         backup.is_hypno = z.is_hypno;
+        scene.update_wave_hp(backup);
 
         z.partners[i] = static_cast<int>(scene.zombies.get_index(backup));
     }
@@ -42,9 +42,11 @@ void zombie_gargantuar::update(zombie& z) {
                     p.col == target->col)
                 {
                     if (p.ignore_garg_smash) {
+#ifndef PVZEMU_LEAN
                         if (z.ignored_smashes.size < 4) {
                             z.ignored_smashes.arr[z.ignored_smashes.size++] = p.uuid;
                         }
+#endif
                     } else {
                         damage(scene).set_smashed(p);
                     }
@@ -86,8 +88,9 @@ void zombie_gargantuar::update(zombie& z) {
         if (!scene.disable_garg_throw_imp) {
             auto& imp = zombie_factory(scene).create(zombie_type::imp);
             imp.spawn_wave = z.spawn_wave;
+            scene.update_wave_hp(imp);
 
-            imp.row = z.row;
+            scene.set_zombie_row(imp, z.row);
             imp.status = zombie_status::imp_flying;
 
             imp.x = z.x - 133.0f;
@@ -122,10 +125,12 @@ void zombie_gargantuar::update(zombie& z) {
             return;
         }
 
-        if (auto p = find_target(z, zombie_attack_type::smash_or_eat)) {
+        if ([[maybe_unused]] auto p = find_target(z, zombie_attack_type::smash_or_eat)) {
+#ifndef PVZEMU_LEAN
             if (z.attempted_smashes.size < 64) {
                 z.attempted_smashes.arr[z.attempted_smashes.size++] = p->uuid;
             }
+#endif
             z.status = zombie_status::gargantuar_smash;
             reanim.set(z, zombie_reanim_name::anim_smash, reanim_type::once, 16);
         }
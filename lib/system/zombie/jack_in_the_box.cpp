@@ -6,12 +6,13 @@ namespace pvz_emulator::system {
 
 using namespace pvz_emulator::object;
 
-void zombie_jack_in_the_box::kill_plants(zombie& z, int x, int y) {
+void zombie_jack_in_the_box::kill_plants([[maybe_unused]] zombie& z, int x, int y) {
     for (auto& p : scene.plants) {
         rect rect;
         p.get_hit_box(rect);
         
         if (rect.is_overlap_with_circle(x, y, 90)) {
+#ifndef PVZEMU_LEAN
             if (z.row == p.row) {
                 p.explode.from_same++;
             } else if (z.row < p.row) {
@@ -19,6 +20,7 @@ void zombie_jack_in_the_box::kill_plants(zombie& z, int x, int y) {
             } else {
                 p.explode.from_lower++;
             }
+#endif
 
             if (!p.ignore_jack_explode){
                 plant_factory(scene).destroy(p);
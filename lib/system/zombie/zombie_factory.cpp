@@ -110,6 +110,8 @@ zombie& zombie_factory::create(zombie_type type, int specified_row)
 		assert(false);
 	}
 
+	scene.update_wave_hp(z);
+
 	return z;
 }
 
@@ -122,14 +124,15 @@ void zombie_factory::create_roof_lurking(
 	auto& z = create(type);
 
 	b.bungee_col = col;
-	b.row = row;
+	scene.set_zombie_row(b, row);
 	b.x = static_cast<float>(80 * col + 40);
 	b.y = zombie_init_y(scene.type, b, row);
 	b.master_id = static_cast<int>(scene.zombies.get_index(z));
+	scene.update_wave_hp(b);
 	reanim.set(b, zombie_reanim_name::anim_raise, reanim_type::once, 36);
 
 	z.x = b.x - 15;
-	z.row = row;
+	scene.set_zombie_row(z, row);
 	z.y = zombie_init_y(scene.type, z, row);
 	z.action = zombie_action::fall_from_sky;
 	reanim.set(z, zombie_reanim_name::anim_idle, reanim_type::repeat, 0);
@@ -146,7 +149,7 @@ void zombie_factory::create_pool_or_night_lurking(
 	z.y = zombie_init_y(scene.type, z, row);
 	z.int_x = static_cast<int>(z.x);
 	z.int_y = static_cast<int>(z.y);
-	z.row = row;
+	scene.set_zombie_row(z, row);
 	z.dy = static_cast<float>(scene.type == scene_type::night ? -200 : -150);
 	z.status = zombie_status::rising_from_ground;
 	z.is_in_water = scene.type != scene_type::night;
@@ -184,6 +187,8 @@ void zombie_factory::create_lurking(
 
 void zombie_factory::destroy(object::zombie& z) {
 	z.is_dead = true;
+	scene.zombies.release(z);
+	scene.update_wave_hp(z);
 
 	if (z.type == zombie_type::bungee) {
         auto p = scene.plants.get(z.bungee_target);
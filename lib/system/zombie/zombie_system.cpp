@@ -18,9 +18,8 @@ zombie* zombie_system::find_hypno_enemy(object::zombie& z) {
     rect zr;
     z.get_attack_box(zr);
 
-    for (auto & enemy : scene.zombies) {
+    for (auto & enemy : scene.zombies_in_row(z.row)) {
         if (z.is_hypno == enemy.is_hypno ||
-            enemy.row != z.row ||
             enemy.status == zombie_status::balloon_flying ||
             enemy.status == zombie_status::balloon_falling ||
             enemy.status == zombie_status::digger_dig ||
@@ -270,7 +269,7 @@ void zombie_system::set_garlic_row_switch(zombie& z) {
 
             assert(z.row >= 0 && z.row <= 5);
 
-            z.row = ROW_LOOKUP[z.row % 6];
+            scene.set_zombie_row(z, ROW_LOOKUP[z.row % 6]);
             break;
         }
 
@@ -279,18 +278,18 @@ void zombie_system::set_garlic_row_switch(zombie& z) {
 
             switch (z.row) {
             case 0:
-                z.row = 1;
+                scene.set_zombie_row(z, 1);
                 break;
 
             case 4:
-                z.row = 3;
+                scene.set_zombie_row(z, 3);
                 break;
 
             default:
                 if (rng.randint(2)) {
-                    --z.row;
+                    scene.set_zombie_row(z, z.row - 1);
                 } else {
-                    ++z.row;
+                    scene.set_zombie_row(z, z.row + 1);
                 }
 
                 break;
@@ -306,6 +305,7 @@ void zombie_system::set_hypno_effect(zombie& z) {
         for (int i = 0; i < 4; i++) {
             z.partners[i] = -1;
         }
+        scene.update_wave_hp(z);
         return;
     }
 
@@ -322,7 +322,10 @@ void zombie_system::set_hypno_effect(zombie& z) {
         z.master_id = -1;
     } else if (auto m = scene.zombies.get(z.master_id)) {
         z.master_id = m->master_id = -1;
+        scene.update_wave_hp(*m);
     }
+
+    scene.update_wave_hp(z);
 }
 
 void zombie_system::set_garlic_and_hypno_status(zombie& z) {
@@ -38,6 +38,7 @@ void zombie_zomboni::update(object::zombie& z) {
 
     if (px < 800) {
         scene.ice_path.countdown[z.row] = 3000;
+        scene.enable_pass(update_pass::ice_path);
     }
 }
 
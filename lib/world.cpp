@@ -1,3 +1,5 @@
+#include <algorithm>
+#include <limits>
 #include <set>
 #include <map>
 #include <unordered_set>
@@ -7,6 +9,7 @@
 #include "rapidjson/stringbuffer.h"
 
 #include "world.h"
+#include "learning/thread_pool.h"
 
 using namespace pvz_emulator::object;
 
@@ -28,7 +31,9 @@ bool world::update() {
 
     clean_obj_lists();
 
-    griditem.update();
+    if (scene.is_pass_enabled(update_pass::griditem)) {
+        griditem.update();
+    }
 
     plant_system.update();
 
@@ -37,27 +42,35 @@ bool world::update() {
         return true;
     }
 
-    projectile.update();
+    if (scene.is_pass_enabled(update_pass::projectile)) {
+        projectile.update();
+    }
 
-    for (auto& card : scene.cards) {
-        if (card.cold_down > 0) {
-            --card.cold_down;
+    if (scene.is_pass_enabled(update_pass::cards)) {
+        for (auto& card : scene.cards) {
+            if (card.cold_down > 0) {
+                --card.cold_down;
+            }
         }
     }
 
-    sun.update();
+    if (scene.is_pass_enabled(update_pass::sun)) {
+        sun.update();
+    }
 
     if (!scene.stop_spawn) {
         spawn.update();
     }
 
-    ice_path.update();
+    if (scene.is_pass_enabled(update_pass::ice_path)) {
+        ice_path.update();
+    }
 
     if (scene.spawn.countdown.pool > 0) {
         --scene.spawn.countdown.pool;
     }
 
-    if (endgame.update()) {
+    if (scene.is_pass_enabled(update_pass::endgame) && endgame.update()) {
         spawn.reset();
         return true;
     } else {
@@ -65,6 +78,85 @@ bool world::update() {
     }
 }
 
+unsigned int world::idle_ticks() {
+    if (scene.is_game_over ||
+        scene.zombies.size() > 0 ||
+        scene.plants.size() > 0 ||
+        scene.griditems.size() > 0 ||
+        scene.projectiles.size() > 0)
+    {
+        return 0;
+    }
+
+    auto n = std::numeric_limits<unsigned int>::max();
+
+    if (scene.is_pass_enabled(update_pass::sun)) {
+        n = std::min(n, sun.idle_ticks());
+    }
+
+    if (!scene.stop_spawn) {
+        n = std::min(n, spawn.idle_ticks());
+    }
+
+    if (scene.is_pass_enabled(update_pass::endgame)) {
+        n = std::min(n, endgame.idle_ticks());
+    }
+
+    return n;
+}
+
+void world::skip_idle(unsigned int n) {
+    scene.zombie_dancing_clock += n;
+
+    if (scene.is_pass_enabled(update_pass::cards)) {
+        for (auto& card : scene.cards) {
+            card.cold_down = card.cold_down > n ? card.cold_down - n : 0;
+        }
+    }
+
+    if (scene.is_pass_enabled(update_pass::sun)) {
+        sun.skip(n);
+    }
+
+    if (!scene.stop_spawn) {
+        spawn.skip(n);
+    }
+
+    if (scene.is_pass_enabled(update_pass::ice_path)) {
+        ice_path.skip(n);
+    }
+
+    auto& pool = scene.spawn.countdown.pool;
+    pool = pool > n ? pool - n : 0;
+
+    if (scene.is_pass_enabled(update_pass::endgame)) {
+        endgame.skip(n);
+    }
+}
+
+bool world::run(unsigned int n, unsigned int& ticks_run) {
+    ticks_run = 0;
+    if (scene.is_game_over) {
+        return true;
+    }
+
+    while (ticks_run < n) {
+        if (auto idle = std::min(idle_ticks(), n - ticks_run)) {
+            skip_idle(idle);
+            ticks_run += idle;
+            continue;
+        }
+
+        ticks_run++;
+
+        if (update()) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 bool world::update(const std::tuple<int, int, int> &action) {
     int op = std::get<0>(action);
     int row = std::get<1>(action);
@@ -96,75 +188,90 @@ bool world::update(const std::tuple<int, int, int> &action) {
     return update();
 }
 
-void world::get_available_actions(
-    const action_vector& actions,
-    std::vector<int>& action_masks) const
+template<typename F>
+void world::for_each_available_action(const action_vector& actions, F f) const
 {
-    std::array<bool, static_cast<int>(plant_type::imitater) + 1> card_flags = {false};
-    std::array<int, static_cast<int>(plant_type::imitater) + 1> card_index = {0};
+    std::array<int, static_cast<int>(plant_type::imitater) + 1> card_index;
+    card_index.fill(-1);
+
     for (int i = 0; i < 10; i++) {
         const auto& card = scene.cards[i];
 
         if (card.type != plant_type::none && card.cold_down == 0) {
-            card_flags[static_cast<int>(card.type)] = true;
             card_index[static_cast<int>(card.type)] = i;
         }
     }
 
-    action_masks.resize(actions.size() + 1, 0);
-    std::fill(action_masks.begin(), action_masks.end(), 0);
-    action_masks.back() = 1;
+    // one pass over the griditems instead of one per planting action
+    system::plant_factory::griditem_cover cover;
+    plant_factory.get_griditem_cover(cover);
 
-    std::set<std::pair<unsigned int, unsigned int>> imitater_type_actions;
-    std::map<int, std::pair<unsigned int, unsigned int>> imitater_actions;
-
-    for (int i = 0; i < actions.size(); i++) {
+    for (size_t i = 0; i < actions.size(); i++) {
         const auto& [op, row, col] = actions[i];
 
         if (row < 0 || row >= scene.rows || col < 0 || col >= 9) {
             continue;
         }
 
+        const auto& status = scene.plant_map[row][col];
+
+        auto is_alive = [](const object::plant* p) {
+            return p && !p->is_dead && !p->is_smashed;
+        };
+
         if (op == -2) {
-            if (scene.plant_map[row][col].pumpkin &&
-                !scene.plant_map[row][col].pumpkin->is_dead &&
-                !scene.plant_map[row][col].pumpkin->is_smashed)
-            {
-                action_masks[i] = 1;
+            if (is_alive(status.pumpkin)) {
+                f(i);
             }
         } else if (op == -1) {
-            if (scene.plant_map[row][col].coffee_bean &&
-                !scene.plant_map[row][col].coffee_bean->is_dead &&
-                !scene.plant_map[row][col].coffee_bean->is_smashed)
-            {
-                action_masks[i] = 1;
-            } else if (scene.plant_map[row][col].content &&
-               !scene.plant_map[row][col].content->is_dead &&
-               !scene.plant_map[row][col].content->is_smashed)
+            if (is_alive(status.coffee_bean) ||
+                is_alive(status.content) ||
+                is_alive(status.base))
             {
-                action_masks[i] = 1;
-            } else if (scene.plant_map[row][col].base &&
-               !scene.plant_map[row][col].base->is_dead &&
-               !scene.plant_map[row][col].base->is_smashed)
-            {
-                action_masks[i] = 1;
+                f(i);
             }
-        } else if (op >= 0) {
-            if (op <= static_cast<int>(plant_type::imitater) &&
-                card_flags[op] &&
-                scene.cards[card_index[op]].cold_down == 0 &&
-                plant_factory.can_plant(
-                    row,
-                    col,
-                    scene.cards[card_index[op]].type,
-                    scene.cards[card_index[op]].imitater_type))
+        } else if (op >= 0 &&
+            op <= static_cast<int>(plant_type::imitater) &&
+            card_index[op] != -1)
+        {
+            const auto& card = scene.cards[card_index[op]];
+
+            if (plant_factory.can_plant_on(
+                row,
+                col,
+                card.type,
+                card.imitater_type,
+                (cover[row][col] & system::plant_factory::GRAVE) != 0,
+                (cover[row][col] & system::plant_factory::CRATER) != 0))
             {
-                action_masks[i] = 1;
+                f(i);
             }
         }
     }
 }
 
+void world::get_available_actions(
+    const action_vector& actions,
+    std::vector<int>& action_masks) const
+{
+    action_masks.resize(actions.size() + 1, 0);
+    std::fill(action_masks.begin(), action_masks.end(), 0);
+    action_masks.back() = 1;
+
+    for_each_available_action(actions, [&](size_t i) { action_masks[i] = 1; });
+}
+
+void world::get_available_action_bits(
+    const action_vector& actions,
+    std::vector<uint64_t>& bits) const
+{
+    bits.resize((actions.size() + 64) / 64);
+    std::fill(bits.begin(), bits.end(), 0);
+    bits.back() |= uint64_t(1) << (actions.size() % 64);
+
+    for_each_available_action(actions, [&](size_t i) { bits[i / 64] |= uint64_t(1) << (i % 64); });
+}
+
 void world::update_all(
     std::vector<world *>& w,
     const action_vector & all_actions,
@@ -175,34 +282,39 @@ void world::update_all(
     std::vector<int>& done,
     unsigned int frames)
 {
-    std::atomic<decltype(w.size())> i = 0;
     done.resize(w.size());
     check_result.resize(w.size());
     action_masks.resize(w.size());
 
-    std::vector<std::thread> threads;
-    for (unsigned int j = 0; j < std::thread::hardware_concurrency(); j++) {
-        threads.emplace_back([&]() {
-            for (auto k = i.fetch_add(1); k < w.size(); k = i.fetch_add(1)) {
-                done[k] = w[k]->update(actions[k]);
-                for (unsigned int l = 0; l < frames - 1 && !done[k]; l++) {
-                    done[k] = w[k]->update();
-                }
-                check_result[k] = w[k]->check_build(build_check_list);
-                w[k]->get_available_actions(all_actions, action_masks[k]);
-            }
-        });
-    }
+    learning::thread_pool::global()->parallel_for(w.size(), [&](size_t k) {
+        done[k] = w[k]->step(
+            all_actions, actions[k], action_masks[k], build_check_list, check_result[k], frames);
+    });
+}
 
-    for (auto& t : threads) {
-        t.join();
+bool world::step(
+    const action_vector& all_actions,
+    const std::tuple<int, int, int>& action,
+    action_masks& masks,
+    const check_list& build_check_list,
+    int& check_result,
+    unsigned int frames)
+{
+    auto done = update(action);
+    for (unsigned int l = 0; l < frames - 1 && !done; l++) {
+        done = update();
     }
+    check_result = check_build(build_check_list);
+    get_available_actions(all_actions, masks);
+
+    return done;
 }
 
 void world::to_json(std::string& s) {
     rapidjson::StringBuffer sb;
     rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
 
+    spawn.get_spawn_list();
     scene.to_json(writer);
 
     s = sb.GetString();
@@ -283,6 +395,8 @@ bool world::select_plants(
         }
     }
 
+    scene.enable_pass(update_pass::cards);
+
     return true;
 }
 
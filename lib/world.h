@@ -37,6 +37,17 @@ public:
 private:
 	void clean_obj_lists();
 
+	// Calls f(i) for each available action i; the no-op is left to the caller.
+	template<typename F>
+	void for_each_available_action(
+		const std::vector<std::tuple<int, int, int>>& actions,
+		F f) const;
+
+	// Ticks that can be skipped in one step: the lawn is empty and no countdown fires within
+	// them, so each would only advance timers.
+	unsigned int idle_ticks();
+	void skip_idle(unsigned int n);
+
 public:
 	world(object::scene_type t):
 		scene(t),
@@ -53,6 +64,21 @@ public:
 		projectile(scene)
 	{}
 
+	world(object::scene_type t, uint32_t seed):
+		scene(t, seed),
+		sun(scene),
+		spawn(scene),
+		ice_path(scene),
+		endgame(scene),
+		griditem(scene),
+		plant_system(scene),
+		plant_factory(scene),
+		zombie_factory(scene),
+		griditem_factory(scene),
+		zombie(scene),
+		projectile(scene)
+	{}
+
 	world(const world& w) :
 		scene(w.scene),
 		sun(scene),
@@ -71,6 +97,30 @@ public:
 	bool update();
 	bool update(const std::tuple<int, int, int>& action);
 
+	// Runs up to n ticks, stopping right after an update() that returns true; returns whether it
+	// stopped that way. ticks_run is set to the number of ticks run, which is 0 if the game was
+	// already over. Spans where the lawn is empty and only countdowns are running are advanced
+	// in one step.
+	bool run(unsigned int n, unsigned int& ticks_run);
+
+	// Like run, but also stops once pred(*this) holds after a tick, and runs tick by tick.
+	template<typename Pred>
+	bool run_until(Pred pred, unsigned int max_ticks, unsigned int& ticks_run) {
+		ticks_run = 0;
+		if (scene.is_game_over) {
+			return true;
+		}
+
+		while (ticks_run < max_ticks) {
+			ticks_run++;
+			if (update() || pred(*this)) {
+				return true;
+			}
+		}
+
+		return false;
+	}
+
     using action_vector = std::vector<std::tuple<int, int, int>>;
 
     using action_masks = std::vector<int>;
@@ -80,6 +130,12 @@ public:
 		const action_vector& actions,
 		std::vector<int>& action_masks) const;
 
+	// Same masks packed into bits: bit i of the result (word i / 64) is set iff action i is
+	// available, and bit actions.size() is the always-available no-op.
+	void get_available_action_bits(
+		const action_vector& actions,
+		std::vector<uint64_t>& bits) const;
+
     using check_list = std::vector<std::tuple<
             object::plant_type,
             unsigned int,
@@ -95,8 +151,38 @@ public:
         std::vector<int>& done,
 		unsigned int frames = 1);
 
+	// One world's share of an update_all step: runs the action and frames - 1 further ticks
+	// (stopping once update() returns true), then fills check_result and masks. Returns
+	// whether the game ended.
+	bool step(
+		const action_vector& all_actions,
+		const std::tuple<int, int, int>& action,
+		action_masks& masks,
+		const check_list& build_check_list,
+		int& check_result,
+		unsigned int frames = 1);
+
 	void to_json(std::string& s);
 
+	using snapshot_data = object::scene::snapshot_data;
+
+	// Saves the whole simulation state; s's buffers are reused, so saving into the same
+	// snapshot_data repeatedly does not allocate.
+	void snapshot(snapshot_data& s) const {
+		scene.snapshot(s);
+	}
+
+	snapshot_data snapshot() const {
+		snapshot_data s;
+		snapshot(s);
+		return s;
+	}
+
+	// Rolls back to a saved state, which may have been taken from another world.
+	void restore(const snapshot_data& s) {
+		scene.restore(s);
+	}
+
 	bool select_plants(
 		const std::vector<object::plant_type>& cards,
 		object::plant_type imitater_type = object::plant_type::none);
@@ -114,6 +200,11 @@ public:
 		spawn.reset();
 	}
 
+	void reset(uint32_t seed) {
+		scene.reset(seed);
+		spawn.reset();
+	}
+
 	void reset(object::scene_type type) {
 		scene.reset(type);
 		spawn.reset();
@@ -2,20 +2,18 @@
  */
 
 #include "common/pe.h"
+#include "common/runner.h"
 #include "common/test.h"
 #include "constants/constants.h"
 #include "seml/reader/lib.h"
 #include "world.h"
 
-#include <mutex>
 #include <optional>
 
 using namespace pvz_emulator;
 using namespace pvz_emulator::object;
 using namespace pvz_emulator::system;
 
-std::mutex mtx;
-
 std::vector<std::vector<std::pair<int, int>>> cob_ranges;
 std::optional<int> ice_time;
 int hit_cob_col = -1;
@@ -90,61 +88,64 @@ void validate_config(Config& config)
             wave.wave_length - wave.start_tick + 1, {COB_RANGE_MIN_INIT, COB_RANGE_MAX_INIT}));
 }
 
-void test(const Config& config, int repeat)
+struct State {
+    world w;
+    std::vector<std::vector<std::pair<int, int>>> cob_ranges;
+};
+
+void test(const Config& config, State& state, int repeat, uint64_t seed)
 {
     const auto& wave = config.waves[0];
-    world w(config.setting.scene_type);
-    std::vector<std::vector<std::pair<int, int>>> local_cob_ranges(3,
-        std::vector<std::pair<int, int>>(
-            wave.wave_length - wave.start_tick + 1, {COB_RANGE_MIN_INIT, COB_RANGE_MAX_INIT}));
+    auto& w = state.w;
+    auto& local_cob_ranges = state.cob_ranges;
 
-    for (int r = 0; r < repeat; r++) {
-        w.scene.reset();
-        w.scene.stop_spawn = true;
+    w.scene.reset(derive_seed(seed, repeat));
+    w.scene.stop_spawn = true;
+    disable_idle_passes(w);
 
-        for (int tick = -100; tick <= wave.wave_length; tick++, run(w, 1)) {
-            if (ice_time.has_value() && tick == *ice_time - 99) {
-                w.plant_factory.create(plant_type::iceshroom, 0, 0, plant_type::none, true);
-            }
+    for (int tick = -100; tick <= wave.wave_length; tick++, run(w, 1)) {
+        if (ice_time.has_value() && tick == *ice_time - 99) {
+            w.plant_factory.create(plant_type::iceshroom, 0, 0, plant_type::none, true);
+        }
 
-            if (tick == 0) {
-                for (const auto& protect_position : config.setting.protect_positions) {
-                    if (protect_position.is_cob()) {
-                        w.plant_factory.create(plant_type::cob_cannon, 1, protect_position.col - 2);
-                    } else {
-                        w.plant_factory.create(
-                            plant_type::umbrella_leaf, 1, protect_position.col - 1);
-                    }
-                }
-                for (int i = 0; i < 1000; i++) {
-                    w.zombie_factory.create(zombie_type::pogo, 1);
+        if (tick == 0) {
+            for (const auto& protect_position : config.setting.protect_positions) {
+                if (protect_position.is_cob()) {
+                    w.plant_factory.create(plant_type::cob_cannon, 1, protect_position.col - 2);
+                } else {
+                    w.plant_factory.create(plant_type::umbrella_leaf, 1, protect_position.col - 1);
                 }
             }
+            for (int i = 0; i < 1000; i++) {
+                w.zombie_factory.create(zombie_type::pogo, 1);
+            }
+        }
 
-            if (tick >= wave.start_tick) {
-                for (auto& z : w.scene.zombies) {
-                    for (int diff = -1; diff <= 1; diff++) {
-                        auto cob_y
-                            = get_cob_hit_xy(w.scene.type, (z.row + 1) + diff, 9.0f, hit_cob_col)
-                                  .second;
-                        const auto new_cob_range = get_cob_hit_x_range(get_hit_box(z), cob_y);
-                        auto& old_cob_range = local_cob_ranges[diff + 1][tick - wave.start_tick];
-
-                        old_cob_range.first = std::max(old_cob_range.first, new_cob_range.first);
-                        old_cob_range.second = std::min(old_cob_range.second, new_cob_range.second);
-                    }
+        if (tick >= wave.start_tick) {
+            for (auto& z : w.scene.zombies) {
+                for (int diff = -1; diff <= 1; diff++) {
+                    auto cob_y
+                        = get_cob_hit_xy(w.scene.type, (z.row + 1) + diff, 9.0f, hit_cob_col)
+                              .second;
+                    const auto new_cob_range = get_cob_hit_x_range(get_hit_box(z), cob_y);
+                    auto& old_cob_range = local_cob_ranges[diff + 1][tick - wave.start_tick];
+
+                    old_cob_range.first = std::max(old_cob_range.first, new_cob_range.first);
+                    old_cob_range.second = std::min(old_cob_range.second, new_cob_range.second);
                 }
             }
         }
     }
+}
 
-    std::lock_guard<std::mutex> lock(mtx);
-    for (int tick = wave.start_tick; tick <= wave.wave_length; tick++) {
-        for (int i = 0; i < 3; i++) {
-            const auto& local_cob_range = local_cob_ranges[i][tick - wave.start_tick];
-            auto& global_cob_range = cob_ranges[i][tick - wave.start_tick];
-            global_cob_range.first = std::max(global_cob_range.first, local_cob_range.first);
-            global_cob_range.second = std::min(global_cob_range.second, local_cob_range.second);
+void merge_cob_ranges(State& into, const State& from)
+{
+    for (size_t i = 0; i < into.cob_ranges.size(); i++) {
+        for (size_t j = 0; j < into.cob_ranges[i].size(); j++) {
+            auto& into_range = into.cob_ranges[i][j];
+            const auto& from_range = from.cob_ranges[i][j];
+            into_range.first = std::max(into_range.first, from_range.first);
+            into_range.second = std::min(into_range.second, from_range.second);
         }
     }
 }
@@ -158,19 +159,19 @@ int main()
     auto config_file = get_cmd_arg(args, "f");
     auto output_file = get_cmd_arg(args, "o", "pogo_test2");
     auto total_repeat_num = std::stoi(get_cmd_arg(args, "r", "1000"));
+    auto seed = get_seed(args);
 
     auto [file, full_output_file] = open_csv(output_file);
 
     auto config = read_json(config_file);
     validate_config(config);
 
-    std::vector<std::thread> threads;
-    for (int repeat : assign_repeat(total_repeat_num, std::thread::hardware_concurrency())) {
-        threads.emplace_back([config, repeat]() { test(config, repeat); });
-    }
-    for (auto& t : threads) {
-        t.join();
-    }
+    cob_ranges = run_repeats(
+        total_repeat_num,
+        [&]() { return State {world(config.setting.scene_type), cob_ranges}; },
+        [&](State& state, int repeat) { test(config, state, repeat, seed); },
+        merge_cob_ranges)->cob_ranges;
+
     file << "时刻,收上行跳跳左,右,收本行跳跳左,右,收下行跳跳左,右," << "\n";
     const auto& wave = config.waves[0];
     for (int tick = wave.start_tick; tick <= wave.wave_length; tick++) {
@@ -197,6 +198,6 @@ int main()
     std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
     std::cout << "输出文件已保存至 " << full_output_file << ".\n"
               << "耗时 " << std::fixed << std::setprecision(2) << elapsed.count() << " 秒, 使用了 "
-              << threads.size() << " 个线程." << std::endl;
+              << get_thread_num(total_repeat_num) << " 个线程, 随机种子 " << seed << "." << std::endl;
     return 0;
 }
\ No newline at end of file
@@ -1,12 +1,11 @@
 /* 测试意外刷新概率.
  */
 
+#include "common/runner.h"
 #include "common/test.h"
 #include "seml/refresh/lib.h"
 #include "world.h"
 
-#include <mutex>
-
 using namespace pvz_emulator;
 using namespace pvz_emulator::object;
 
@@ -44,103 +43,139 @@ double get_accident_rate(int init_hp, int curr_hp, bool assume_activate)
     return assume_activate ? 1.0 - refresh_prob : refresh_prob;
 }
 
-std::mutex mtx;
-TestInfos test_infos;
+// one per round, merged in round order once all threads finish so that the float sums and the
+// raw log do not depend on the thread count
+std::vector<TestInfos> round_test_infos;
+
+const int CI_ROUND_SIZE = 100;
+
+// Widest 95% confidence half-width of the average accident rates (in %) over rounds
+// [0, round_num). A round's tests share one set of spawn types, so each round's average counts as
+// one sample.
+double get_max_ci_half_width(int round_num)
+{
+    std::vector<double> sums, square_sums;
+    for (int round = 0; round < round_num; round++) {
+        const auto& test_infos = round_test_infos[round].test_infos;
+        sums.resize(test_infos.size());
+        square_sums.resize(test_infos.size());
+
+        for (size_t i = 0; i < test_infos.size(); i++) {
+            double sum = 0;
+            int count = 0;
+            for (const auto& [zombie_types, accident_rate] : test_infos[i].merged_accident_rates) {
+                sum += accident_rate.first;
+                count += accident_rate.second;
+            }
+
+            auto average = sum / count;
+            sums[i] += average;
+            square_sums[i] += average * average;
+        }
+    }
+
+    double max_half_width = 0.0;
+    for (size_t i = 0; i < sums.size(); i++) {
+        max_half_width
+            = std::max(max_half_width, 100.0 * get_ci_half_width(sums[i], square_sums[i], round_num));
+    }
+    return max_half_width;
+}
+
+struct State {
+    world w;
+    std::vector<Test> tests; // one per wave, reused across tests
+};
 
-void test_one(const Config& config, int repeat, const ZombieTypes& required_types,
-    const ZombieTypes& banned_types, bool huge, bool assume_activate,
-    zombie_dance_cheat dance_cheat, bool natural)
+void test_one(const Config& config, const std::vector<Program>& programs, State& state, int round,
+    uint64_t seed, const ZombieTypes& required_types, const ZombieTypes& banned_types, bool huge,
+    bool assume_activate, zombie_dance_cheat dance_cheat, bool natural)
 {
-    std::mt19937 rng(
-        static_cast<unsigned int>(std::chrono::steady_clock::now().time_since_epoch().count()));
-    world w(config.setting.scene_type);
+    auto& w = state.w;
+    auto& tests = state.tests;
+    tests.resize(programs.size());
+
+    auto& local_test_infos = round_test_infos[round];
+
+    w.scene.reset(derive_seed(seed, round));
     w.scene.stop_spawn = true;
-    TestInfos local_test_infos;
-
-    for (int round_idx = 0; round_idx < repeat; round_idx++) {
-        auto spawn_types = get_spawn_types(
-            rng, config.setting.original_scene_type, required_types, banned_types);
-
-        for (int wave_idx = 0; wave_idx < 20; wave_idx++) { // test 20 times for each repeat
-            /*
-            TODO: refactor wave logic
-            - use actual wave data from config
-            - set wave in insert_spawn
-            - consider giga limit (generate a full list for each test,
-              and only retain the specified wave)
-            - deprecate huge (use w10 instead)
-            */
-            std::vector<Test> tests;
-            tests.reserve(config.waves.size());
-
-            for (const auto& wave : config.waves) {
-                Test test;
-                load_wave(config.setting, wave, get_spawn_list(rng, spawn_types, huge, natural),
-                    huge, dance_cheat, test);
-
-                w.scene.zombies.clear();
-                w.scene.plants.clear();
-                w.scene.griditems.clear();
-                w.scene.projectiles.clear();
-                if (dance_cheat == zombie_dance_cheat::slow) {
-                    w.scene.is_zombie_dance = true;
-                }
+    std::mt19937 rng(w.scene.rng());
+
+    auto spawn_types = get_spawn_types(
+        rng, config.setting.original_scene_type, required_types, banned_types);
+
+    for (int wave_idx = 0; wave_idx < 20; wave_idx++) { // test 20 times for each repeat
+        /*
+        TODO: refactor wave logic
+        - use actual wave data from config
+        - set wave in run_spawn
+        - consider giga limit (generate a full list for each test,
+          and only retain the specified wave)
+        - deprecate huge (use w10 instead)
+        */
+        for (size_t i = 0; i < programs.size(); i++) {
+            const auto& program = programs[i];
+            const auto& wave = config.waves[i];
+            auto& test = tests[i];
+            load_wave(program, get_spawn_list(rng, spawn_types, huge, natural), test);
+
+            w.scene.zombies.clear();
+            w.scene.plants.clear();
+            w.scene.griditems.clear();
+            w.scene.projectiles.clear();
+            if (dance_cheat == zombie_dance_cheat::slow) {
+                w.scene.is_zombie_dance = true;
+            }
 
-                auto it = test.ops.begin();
-                int curr_tick = it->tick; // there is at least 1 op (spawn)
-                do {
-                    run(w, curr_tick, it->tick);
-                    it->f(w);
-                    it++;
-                } while (curr_tick < 0);
-
-                test.log.init_hp = test.init_hp;
-                for (auto typ : spawn_types) {
-                    test.log.zombie_count[int(typ)] = std::array<int, 5>();
+            auto it = program.ops.begin();
+            int curr_tick = it->tick; // there is at least 1 op (spawn)
+            do {
+                run(w, curr_tick, it->tick);
+                run_op(w, program, *it, test);
+                it++;
+            } while (curr_tick < 0);
+
+            test.log.init_hp = test.init_hp;
+            for (auto typ : spawn_types) {
+                test.log.zombie_count[int(typ)] = std::array<int, 5>();
+            }
+            for (const auto& z : w.scene.zombies) {
+                if (z.is_hypno ||
+                    z.has_death_status() ||
+                    z.master_id != -1) {
+                    continue;
                 }
-                for (const auto& z : w.scene.zombies) {
-                    if (z.is_hypno ||
-                        z.has_death_status() ||
-                        z.master_id != -1) {
-                        continue;
-                    }
-                    auto& cnt = test.log.zombie_count[int(z.type)];
-                    if (cnt) {
-                        cnt.value()[0]++;
-                    }
+                auto& cnt = test.log.zombie_count[int(z.type)];
+                if (cnt) {
+                    cnt.value()[0]++;
                 }
+            }
 
-                for (; it != test.ops.end() && it->tick < wave.wave_length - 200; it++) {
-                    run(w, curr_tick, it->tick);
-                    it->f(w);
+            for (; it != program.ops.end() && it->tick < wave.wave_length - 200; it++) {
+                run(w, curr_tick, it->tick);
+                run_op(w, program, *it, test);
+            }
+            run(w, curr_tick, wave.wave_length - 200);
+
+            auto curr_hp = w.spawn.get_current_hp();
+            auto accident_rate = get_accident_rate(test.init_hp, curr_hp, assume_activate);
+            test.accident_rates[spawn_types].push_back(static_cast<float>(accident_rate));
+
+            test.log.curr_hp = curr_hp;
+            for (const auto& z : w.scene.zombies) {
+                if (z.is_hypno ||
+                    z.has_death_status() ||
+                    z.master_id != -1) {
+                    continue;
                 }
-                run(w, curr_tick, wave.wave_length - 200);
-
-                auto curr_hp = w.spawn.get_current_hp();
-                auto accident_rate = get_accident_rate(test.init_hp, curr_hp, assume_activate);
-                test.accident_rates[spawn_types].push_back(static_cast<float>(accident_rate));
-
-                test.log.curr_hp = curr_hp;
-                for (const auto& z : w.scene.zombies) {
-                    if (z.is_hypno ||
-                        z.has_death_status() ||
-                        z.master_id != -1) {
-                        continue;
-                    }
-                    auto& cnt = test.log.zombie_count[int(z.type)];
-                    if (cnt) {
-                        cnt.value()[(z.hp + 1799) / 1800]++;
-                    }
+                auto& cnt = test.log.zombie_count[int(z.type)];
+                if (cnt) {
+                    cnt.value()[(z.hp + 1799) / 1800]++;
                 }
-
-                tests.push_back(std::move(test));
             }
-            local_test_infos.update(tests);
         }
+        local_test_infos.update(tests);
     }
-
-    std::lock_guard<std::mutex> guard(mtx);
-    test_infos.merge(local_test_infos);
 }
 
 int get_zombie_max_hit(zombie_type typ) {
@@ -189,7 +224,9 @@ int main()
     auto args = parse_cmd_line();
     auto config_file = get_cmd_arg(args, "f");
     auto output_file = get_cmd_arg(args, "o", "refresh_test");
-    auto total_repeat_num = std::stoi(get_cmd_arg(args, "r", "1000"));
+    auto ci_width = get_cmd_arg(args, "ci", ""); // with -ci, -r is the maximum
+    auto total_repeat_num = std::stoi(get_cmd_arg(args, "r", ci_width.empty() ? "1000" : "10000"));
+    auto seed = get_seed(args);
     auto required_types = parse_zombie_types(get_cmd_arg(args, "req", ""));
     auto banned_types = parse_zombie_types(get_cmd_arg(args, "ban", ""));
     auto huge = get_cmd_flag(args, "h");
@@ -204,16 +241,36 @@ int main()
     auto config = read_json(config_file);
     validate_config(config);
 
-    std::vector<std::thread> threads;
-    for (int repeat : assign_repeat(total_repeat_num, std::thread::hardware_concurrency())) {
-        threads.emplace_back([config, repeat, required_types, banned_types, huge, assume_activate,
-                                 dance_cheat, natural]() {
-            test_one(config, repeat, required_types, banned_types, huge, assume_activate,
-                dance_cheat, natural);
-        });
+    round_test_infos.resize(total_repeat_num);
+
+    std::vector<Program> programs;
+    programs.reserve(config.waves.size());
+    for (const auto& wave : config.waves) {
+        programs.push_back(compile_wave(config.setting, wave, huge, dance_cheat));
     }
-    for (auto& t : threads) {
-        t.join();
+
+    auto make_state = [&]() { return State {world(config.setting.scene_type), {}}; };
+    auto run_one = [&](State& state, int round) {
+        test_one(config, programs, state, round, seed, required_types, banned_types, huge,
+            assume_activate, dance_cheat, natural);
+    };
+    auto merge = [](State&, State&) {};
+
+    if (ci_width.empty()) {
+        run_repeats(total_repeat_num, make_state, run_one, merge);
+    } else {
+        // stop once every column's average accident rate is known to within ±ci_width (in %)
+        auto max_half_width = std::stod(ci_width);
+        total_repeat_num = run_repeats_until(total_repeat_num, CI_ROUND_SIZE, make_state, run_one,
+            merge, [&](const State&, int round_num) {
+                return get_max_ci_half_width(round_num) <= max_half_width;
+            }).second;
+        round_test_infos.resize(total_repeat_num);
+    }
+
+    TestInfos test_infos;
+    for (const auto& round_test_info : round_test_infos) {
+        test_infos.merge(round_test_info);
     }
 
     std::vector<std::vector<std::string>> headers(config.waves.size());
@@ -280,6 +337,12 @@ int main()
         file << "\n";
     }
 
+    if (!ci_width.empty()) {
+        file << "\n95%置信区间半宽 (平均意外率)," << get_max_ci_half_width(total_repeat_num)
+             << "%\n";
+        file << "重复次数," << total_repeat_num << "\n";
+    }
+
     if (enable_raw) {
         auto [log_file, log_filename] = open_csv(output_file + "_raw");
         write_log(log_file, test_infos);
@@ -288,7 +351,7 @@ int main()
     std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
     std::cout << "输出文件已保存至 " << full_output_file << ".\n"
               << "耗时 " << std::fixed << std::setprecision(2) << elapsed.count() << " 秒, 使用了 "
-              << threads.size() << " 个线程." << std::endl;
+              << get_thread_num(total_repeat_num) << " 个线程, 随机种子 " << seed << "." << std::endl;
 
     return 0;
 }
\ No newline at end of file
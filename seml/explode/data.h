@@ -25,25 +25,39 @@ struct TestInfo {
 
     int start_tick;
     std::vector<LossInfo> merged_loss_info;
+    // per tick, sum over repeats of the squared total loss (explode * 300 + hp_loss)
+    std::vector<int64_t> loss_squares;
 
-private:
-    void update(const Test& test)
+    // Total loss of loss_info, in hp.
+    static int64_t get_loss(const LossInfo& loss_info)
     {
-        if (merged_loss_info.empty()) {
-            merged_loss_info.resize(test.loss_infos.size());
-            start_tick = test.start_tick;
-        }
-
-        assert(start_tick == test.start_tick);
+        int64_t explode = loss_info.explode.from_upper + loss_info.explode.from_same
+            + loss_info.explode.from_lower;
+        return explode * 300 + loss_info.hp_loss;
+    }
 
-        for (size_t tick = 0; tick < test.loss_infos.size(); tick++) {
-            const auto& loss_info = test.loss_infos.at(tick);
+private:
+    void init(const Program& program)
+    {
+        start_tick = program.start_tick;
+        auto tick_num
+            = static_cast<size_t>(std::max(program.wave_length - program.start_tick + 1, 0));
+        merged_loss_info.resize(tick_num);
+        loss_squares.resize(tick_num);
+    }
 
-            for (const auto& plant : test.protect_plants) {
-                merged_loss_info[tick].explode += loss_info[plant->row].explode;
-                merged_loss_info[tick].hp_loss += loss_info[plant->row].hp_loss;
-            }
+    void add_loss(int tick, const Test& test)
+    {
+        auto& merged = merged_loss_info.at(static_cast<size_t>(tick - start_tick));
+
+        int64_t loss = 0;
+        for (const auto& plant : test.protect_plants) {
+            LossInfo loss_info = {plant->explode, plant->max_hp - plant->hp};
+            merged.explode += loss_info.explode;
+            merged.hp_loss += loss_info.hp_loss;
+            loss += get_loss(loss_info);
         }
+        loss_squares[static_cast<size_t>(tick - start_tick)] += loss * loss;
     }
 
     void merge(const TestInfo& other)
@@ -53,6 +67,7 @@ private:
         for (size_t tick = 0; tick < other.merged_loss_info.size(); tick++) {
             merged_loss_info[tick].explode += other.merged_loss_info[tick].explode;
             merged_loss_info[tick].hp_loss += other.merged_loss_info[tick].hp_loss;
+            loss_squares[tick] += other.loss_squares[tick];
         }
     }
 };
@@ -61,16 +76,25 @@ struct Table {
     std::vector<TestInfo> test_infos;
     int repeat = 0;
 
-    void update(const std::vector<Test>& tests)
+    // Sizes the per-tick sums of every wave; does nothing once they are sized.
+    void init(const std::vector<Program>& programs)
     {
         if (test_infos.empty()) {
-            test_infos.resize(tests.size());
+            test_infos.resize(programs.size());
+            for (size_t i = 0; i < programs.size(); i++) {
+                test_infos[i].init(programs[i]);
+            }
         }
+    }
 
-        for (size_t i = 0; i < tests.size(); i++) {
-            test_infos[i].update(tests.at(i));
-        }
+    // Adds the loss of test's protect plants at tick of wave i, for the current repeat.
+    void add_loss(size_t i, int tick, const Test& test)
+    {
+        test_infos[i].add_loss(tick, test);
+    }
 
+    void finish_repeat()
+    {
         repeat++;
     }
 
@@ -86,4 +110,19 @@ struct Table {
             repeat += other.repeat;
         }
     }
+
+    // Widest 95% confidence half-width of the mean total loss over the ticks of wave i.
+    double get_max_ci_half_width(size_t i) const
+    {
+        const auto& test_info = test_infos.at(i);
+
+        double max_half_width = 0.0;
+        for (size_t tick = 0; tick < test_info.merged_loss_info.size(); tick++) {
+            auto half_width = get_ci_half_width(
+                static_cast<double>(TestInfo::get_loss(test_info.merged_loss_info[tick])),
+                static_cast<double>(test_info.loss_squares[tick]), repeat);
+            max_half_width = std::max(max_half_width, half_width);
+        }
+        return max_half_width;
+    }
 };
\ No newline at end of file
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "seml/reader/types.h"
 #include "seml/types.h"
 
 struct LossInfo {
@@ -7,11 +8,19 @@ struct LossInfo {
     int hp_loss = 0;
 };
 
-// One test contains one wave.
-struct Test {
+// One wave compiled by compile_wave. Refers to the config's actions, so the config must outlive
+// it.
+struct Program {
     int start_tick;
-    std::vector<std::array<LossInfo, 6>> loss_infos;
+    int wave_length;
+    std::vector<Setting::ProtectPos> protect_positions;
+    std::vector<ProgramOp> ops; // sorted by tick
+    std::vector<const Action*> actions;
+    size_t slot_num = 0;
+};
+
+// One test contains one wave. Reused across repeats by load_wave.
+struct Test {
     std::vector<pvz_emulator::object::plant*> protect_plants;
-    std::vector<std::vector<unique_plant>> plants_to_be_shoveled;
-    std::vector<Op> ops;
+    std::vector<std::vector<unique_plant>> plants_to_be_shoveled; // by ProgramOp::slot
 };
\ No newline at end of file
@@ -2,10 +2,18 @@
 
 #include <optional>
 
+#include "common/pe.h"
 #include "constants/constants.h"
 #include "reader/types.h"
+#include "types.h"
 #include "world.h"
 
+const std::unordered_set<pvz_emulator::object::zombie_type> GARG_TYPES
+    = {pvz_emulator::object::zombie_type::giga_gargantuar,
+        pvz_emulator::object::zombie_type::gargantuar};
+const std::unordered_set<pvz_emulator::object::zombie_type> LADDER_JACK_TYPES
+    = {pvz_emulator::object::zombie_type::ladder, pvz_emulator::object::zombie_type::jack_in_the_box};
+
 pvz_emulator::object::plant& plant_fodder(
     pvz_emulator::world& w, const Fodder& fodder, const CardPos& pos)
 {
@@ -168,3 +176,144 @@ int get_cob_fly_time(
         return 373;
     }
 }
+
+// Appends the ops of an action happening at tick (the cob's landing tick, the card's effect tick
+// etc.), in the order they used to be inserted. Cards and fodders that can be shoveled need a slot.
+void compile_action(std::vector<ProgramOp>& ops, std::vector<const Action*>& actions, int tick,
+    const Action* action, const pvz_emulator::object::scene_type& scene_type, int slot)
+{
+    auto idx = static_cast<unsigned int>(actions.size());
+    actions.push_back(action);
+
+    auto shovel_time = -1;
+    if (auto a = dynamic_cast<const Cob*>(action)) {
+        for (unsigned int i = 0; i < a->positions.size(); i++) {
+            const auto& pos = a->positions[i];
+            ops.push_back({tick - get_cob_fly_time(scene_type, pos.row, pos.col, a->cob_col),
+                ProgramOp::Type::Cob, idx, i, slot});
+        }
+    } else if (auto a = dynamic_cast<const FixedCard*>(action)) {
+        ops.push_back(
+            {get_fixed_card_op_tick(a, tick), ProgramOp::Type::FixedCard, idx, 0, slot});
+        shovel_time = a->shovel_time;
+    } else if (auto a = dynamic_cast<const SmartCard*>(action)) {
+        ops.push_back(
+            {get_smart_card_op_tick(a, tick), ProgramOp::Type::SmartCard, idx, 0, slot});
+    } else if (auto a = dynamic_cast<const FixedFodder*>(action)) {
+        ops.push_back({tick, ProgramOp::Type::FixedFodder, idx, 0, slot});
+        shovel_time = a->shovel_time;
+    } else if (auto a = dynamic_cast<const SmartFodder*>(action)) {
+        auto type = ProgramOp::Type::SmartFodderAll;
+        if (a->symbol == "C_POS") {
+            type = ProgramOp::Type::SmartFodderByGigaPos;
+        } else if (a->symbol == "C_NUM") {
+            type = ProgramOp::Type::SmartFodderByNum;
+        } else {
+            assert(a->symbol == "C");
+        }
+        ops.push_back({tick, type, idx, 0, slot});
+        shovel_time = a->shovel_time;
+    } else {
+        assert(false && "unreachable");
+    }
+
+    if (shovel_time != -1) {
+        ops.push_back({tick - action->time + shovel_time, ProgramOp::Type::Shovel, idx, 0, slot});
+    }
+}
+
+// Runs an op made by compile_action, or an ice op. plants is the list of the op's slot (nullptr
+// if it has none): created plants are appended to it and Shovel destroys the ones still alive.
+void run_action_op(pvz_emulator::world& w, const ProgramOp& op,
+    const std::vector<const Action*>& actions, std::vector<unique_plant>* plants)
+{
+    using namespace pvz_emulator::object;
+
+    auto record = [plants](plant& p) {
+        if (plants) {
+            plants->push_back({&p, p.uuid});
+        }
+    };
+
+    switch (op.type) {
+    case ProgramOp::Type::Ice:
+        w.plant_factory.create(plant_type::iceshroom, 0, 0, plant_type::none, true);
+        break;
+
+    case ProgramOp::Type::Cob: {
+        auto cob = static_cast<const Cob*>(actions[op.action]);
+        const auto& pos = cob->positions[op.position];
+        auto uuid = launch_cob(w, pos.row, pos.col, cob->cob_col);
+        if (plants) {
+            plants->push_back({nullptr, uuid});
+        }
+        break;
+    }
+
+    case ProgramOp::Type::FixedCard: {
+        auto card = static_cast<const FixedCard*>(actions[op.action]);
+        record(w.plant_factory.create(
+            card->plant_type, card->position.row - 1, card->position.col - 1));
+        break;
+    }
+
+    case ProgramOp::Type::SmartCard: {
+        auto card = static_cast<const SmartCard*>(actions[op.action]);
+        auto chosen = choose_by_num(w, card->positions, 1, {}, GARG_TYPES,
+            get_smart_card_max_card_zombie_row_diff(card));
+        assert(chosen.size() == 1);
+
+        const auto& pos = card->positions[chosen[0]];
+        record(w.plant_factory.create(card->plant_type, pos.row - 1, pos.col - 1));
+        break;
+    }
+
+    case ProgramOp::Type::FixedFodder: {
+        auto fodder = static_cast<const FixedFodder*>(actions[op.action]);
+        assert(fodder->fodders.size() == fodder->positions.size());
+
+        for (size_t i = 0; i < fodder->fodders.size(); i++) {
+            record(plant_fodder(w, fodder->fodders[i], fodder->positions[i]));
+        }
+        break;
+    }
+
+    case ProgramOp::Type::SmartFodderAll:
+    case ProgramOp::Type::SmartFodderByGigaPos:
+    case ProgramOp::Type::SmartFodderByNum: {
+        auto fodder = static_cast<const SmartFodder*>(actions[op.action]);
+        assert(fodder->fodders.size() == fodder->positions.size());
+
+        if (op.type == ProgramOp::Type::SmartFodderAll) {
+            for (size_t i = 0; i < fodder->positions.size(); i++) {
+                record(plant_fodder(w, fodder->fodders[i], fodder->positions[i]));
+            }
+            break;
+        }
+
+        auto chosen = op.type == ProgramOp::Type::SmartFodderByGigaPos
+            ? choose_by_giga_pos(w, fodder->positions, fodder->choose, fodder->waves)
+            : choose_by_num(
+                w, fodder->positions, fodder->choose, fodder->waves, LADDER_JACK_TYPES, 0);
+        for (auto i : chosen) {
+            record(plant_fodder(w, fodder->fodders[i], fodder->positions[i]));
+        }
+        break;
+    }
+
+    case ProgramOp::Type::Shovel:
+        assert(plants);
+        for (const auto& plant : *plants) {
+            if (plant.is_valid()) {
+                w.plant_factory.destroy(*plant.ptr);
+            }
+        }
+        break;
+
+    case ProgramOp::Type::Setup:
+    case ProgramOp::Type::Spawn:
+    default:
+        assert(false && "unreachable");
+        break;
+    }
+}
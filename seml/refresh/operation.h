@@ -11,195 +11,76 @@ using plant_type = pvz_emulator::object::plant_type;
 using zombie_type = pvz_emulator::object::zombie_type;
 using zombie_dance_cheat = pvz_emulator::object::zombie_dance_cheat;
 
-void insert_spawn(Test& test, int tick, const std::array<zombie_type, 50>& spawn_list, bool huge,
-    zombie_dance_cheat dance_cheat)
+void run_spawn(pvz_emulator::world& w, const Program& program, Test& test)
 {
-    auto f = [&test, tick, spawn_list, huge, dance_cheat](pvz_emulator::world& w) {
-        auto spawn_wave = huge ? 9 : 5;
-        w.scene.spawn.wave = spawn_wave;
-        for (const auto& type : spawn_list) {
-            auto& z = w.zombie_factory.create(type);
-            if ((type == zombie_type::zombie || type == zombie_type::conehead
-                    || type == zombie_type::buckethead)
-                && dance_cheat != zombie_dance_cheat::none) {
-                z.dance_cheat = dance_cheat;
-            }
+    auto spawn_wave = program.huge ? 9 : 5;
+    w.scene.spawn.wave = spawn_wave;
+    for (const auto& type : test.spawn_list) {
+        auto& z = w.zombie_factory.create(type);
+        if ((type == zombie_type::zombie || type == zombie_type::conehead
+                || type == zombie_type::buckethead)
+            && program.dance_cheat != zombie_dance_cheat::none) {
+            z.dance_cheat = program.dance_cheat;
         }
-        w.scene.spawn.wave++; // required for get_current_hp() to work correctly
-        test.init_hp = static_cast<int>(w.spawn.get_current_hp());
-    };
-    test.ops.push_back({tick, f});
+    }
+    w.scene.spawn.wave++; // required for get_current_hp() to work correctly
+    test.init_hp = static_cast<int>(w.spawn.get_current_hp());
 }
 
-void insert_ice(Test& test, int tick)
-{
-    auto f = [](pvz_emulator::world& w) {
-        w.plant_factory.create(plant_type::iceshroom, 0, 0, plant_type::none, true);
-    };
-    test.ops.push_back({tick, f});
-}
+} // namespace _refresh_internal
 
-void insert_cob(Test& test, int tick, const Cob* cob, const scene_type& scene_type)
+Program compile_wave(const Setting& setting, const Wave& wave, bool huge,
+    pvz_emulator::object::zombie_dance_cheat dance_cheat)
 {
-    auto cob_col = cob->cob_col;
+    Program program;
+    program.huge = huge;
+    program.dance_cheat = dance_cheat;
 
-    for (const auto& pos : cob->positions) {
-        auto f = [&test, pos, cob_col](
-                     pvz_emulator::world& w) { launch_cob(w, pos.row, pos.col, cob_col); };
-        test.ops.push_back({tick - get_cob_fly_time(scene_type, pos.row, pos.col, cob_col), f});
-    }
-}
+    auto& ops = program.ops;
 
-void insert_fixed_card(Test& test, int tick, const FixedCard* fixed_card)
-{
-    test.plants_to_be_shoveled.push_back({});
-    auto idx = test.plants_to_be_shoveled.size() - 1;
-    auto plant_type = fixed_card->plant_type;
-    auto pos = fixed_card->position;
-
-    auto f = [&test, idx, plant_type, pos](pvz_emulator::world& w) {
-        auto& p = w.plant_factory.create(plant_type, pos.row - 1, pos.col - 1);
-        test.plants_to_be_shoveled[idx].push_back({&p, p.uuid});
-    };
-    test.ops.push_back({get_fixed_card_op_tick(fixed_card, tick), f});
-
-    if (fixed_card->shovel_time != -1) {
-        auto f = [&test, idx](pvz_emulator::world& w) {
-            for (auto plant : test.plants_to_be_shoveled[idx]) {
-                if (plant.is_valid()) {
-                    w.plant_factory.destroy(*plant.ptr);
-                }
-            }
-        };
-        test.ops.push_back({tick - fixed_card->time + fixed_card->shovel_time, f});
-    }
-}
+    int base_tick = 0;
+    ops.push_back({base_tick, ProgramOp::Type::Spawn, 0, 0, -1});
 
-void insert_smart_card(Test& test, int tick, const SmartCard* smart_card)
-{
-    auto plant_type = smart_card->plant_type;
-    auto positions = smart_card->positions;
-    int max_card_zombie_row_diff = get_smart_card_max_card_zombie_row_diff(smart_card);
-
-    auto f = [&test, plant_type, positions, max_card_zombie_row_diff](pvz_emulator::world& w) {
-        auto chosen = choose_by_num(w, positions, 1, {},
-            {zombie_type::giga_gargantuar, zombie_type::gargantuar}, max_card_zombie_row_diff);
-        assert(chosen.size() == 1);
-
-        auto pos = positions[chosen[0]];
-        w.plant_factory.create(plant_type, pos.row - 1, pos.col - 1);
-    };
-    test.ops.push_back({get_smart_card_op_tick(smart_card, tick), f});
-}
+    for (const auto& ice_time : wave.ice_times) {
+        ops.push_back({base_tick + ice_time - 99, ProgramOp::Type::Ice, 0, 0, -1});
+    }
 
-void insert_fixed_fodder(Test& test, int tick, const FixedFodder* fodder)
-{
-    test.plants_to_be_shoveled.push_back({});
-    auto idx = test.plants_to_be_shoveled.size() - 1;
-    auto fodders = fodder->fodders;
-    auto positions = fodder->positions;
+    for (const auto& action : wave.actions) {
+        auto a = action.get();
+        auto slot = dynamic_cast<const Cob*>(a) || dynamic_cast<const SmartCard*>(a)
+            ? -1
+            : static_cast<int>(program.slot_num++);
+        compile_action(ops, program.actions, base_tick + a->time, a, setting.scene_type, slot);
+    }
 
-    auto f = [&test, idx, fodders, positions](pvz_emulator::world& w) {
-        assert(fodders.size() == positions.size());
+    std::stable_sort(ops.begin(), ops.end(),
+        [](const ProgramOp& a, const ProgramOp& b) { return a.tick < b.tick; });
 
-        for (size_t i = 0; i < fodders.size(); i++) {
-            auto& p = plant_fodder(w, fodders[i], positions[i]);
-            test.plants_to_be_shoveled[idx].push_back({&p, p.uuid});
-        }
-    };
-    test.ops.push_back({tick, f});
-
-    if (fodder->shovel_time != -1) {
-        auto f = [&test, idx](pvz_emulator::world& w) {
-            for (const auto& fodder : test.plants_to_be_shoveled[idx]) {
-                if (fodder.is_valid()) {
-                    w.plant_factory.destroy(*fodder.ptr);
-                }
-            }
-        };
-        test.ops.push_back({tick + fodder->shovel_time - fodder->time, f});
-    }
+    return program;
 }
 
-void insert_smart_fodder(Test& test, int tick, const SmartFodder* fodder)
+// Prepares test for a new repeat of program with the given spawn list, keeping its buffers.
+void load_wave(const Program& program, const ZombieList& spawn_list, Test& test)
 {
-    test.plants_to_be_shoveled.push_back({});
-    auto idx = test.plants_to_be_shoveled.size() - 1;
-    auto symbol = fodder->symbol;
-    auto fodders = fodder->fodders;
-    auto positions = fodder->positions;
-    auto choose = fodder->choose;
-    auto waves = fodder->waves;
-
-    auto f = [&test, idx, symbol, fodders, positions, choose, waves](pvz_emulator::world& w) {
-        assert(fodders.size() == positions.size());
-
-        std::vector<size_t> chosen;
-        if (symbol == "C") {
-            chosen.reserve(positions.size());
-            for (size_t i = 0; i < positions.size(); i++) {
-                chosen.push_back(i);
-            }
-        } else if (symbol == "C_POS") {
-            chosen = choose_by_giga_pos(w, positions, choose, waves);
-        } else if (symbol == "C_NUM") {
-            chosen = choose_by_num(w, positions, choose, waves,
-                {zombie_type::ladder, zombie_type::jack_in_the_box}, 0);
-        } else {
-            assert(false && "unreachable");
-        }
-
-        for (auto i : chosen) {
-            auto& p = plant_fodder(w, fodders[i], positions[i]);
-            test.plants_to_be_shoveled[idx].push_back({&p, p.uuid});
-        }
-    };
-    test.ops.push_back({tick, f});
-
-    if (fodder->shovel_time != -1) {
-        auto f = [&test, idx](pvz_emulator::world& w) {
-            for (const auto& fodder : test.plants_to_be_shoveled[idx]) {
-                if (fodder.is_valid()) {
-                    w.plant_factory.destroy(*fodder.ptr);
-                }
-            }
-        };
-        test.ops.push_back({tick + fodder->shovel_time - fodder->time, f});
+    test.init_hp = 0;
+    test.spawn_list = spawn_list;
+    test.accident_rates.clear();
+    test.log = {};
+
+    test.plants_to_be_shoveled.resize(program.slot_num);
+    for (auto& plants : test.plants_to_be_shoveled) {
+        plants.clear();
     }
 }
 
-} // namespace _refresh_internal
-
-void load_wave(const Setting& setting, const Wave& wave, const ZombieList& spawn_list, bool huge,
-    pvz_emulator::object::zombie_dance_cheat dance_cheat, Test& test)
+void run_op(pvz_emulator::world& w, const Program& program, const ProgramOp& op, Test& test)
 {
     using namespace _refresh_internal;
 
-    test = {};
-
-    int base_tick = 0;
-    insert_spawn(test, base_tick, spawn_list, huge, dance_cheat);
-
-    for (const auto& ice_time : wave.ice_times) {
-        insert_ice(test, base_tick + ice_time - 99);
-    }
-
-    for (const auto& action : wave.actions) {
-        if (auto a = dynamic_cast<const Cob*>(action.get())) {
-            insert_cob(test, base_tick + a->time, a, setting.scene_type);
-        } else if (auto a = dynamic_cast<const FixedCard*>(action.get())) {
-            insert_fixed_card(test, base_tick + a->time, a);
-        } else if (auto a = dynamic_cast<const SmartCard*>(action.get())) {
-            insert_smart_card(test, base_tick + a->time, a);
-        } else if (auto a = dynamic_cast<const FixedFodder*>(action.get())) {
-            insert_fixed_fodder(test, base_tick + a->time, a);
-        } else if (auto a = dynamic_cast<const SmartFodder*>(action.get())) {
-            insert_smart_fodder(test, base_tick + a->time, a);
-        } else {
-            assert(false && "unreachable");
-        }
+    if (op.type == ProgramOp::Type::Spawn) {
+        run_spawn(w, program, test);
+    } else {
+        run_action_op(w, op, program.actions,
+            op.slot >= 0 ? &test.plants_to_be_shoveled[static_cast<size_t>(op.slot)] : nullptr);
     }
-
-    std::stable_sort(
-        test.ops.begin(), test.ops.end(), [](const Op& a, const Op& b) { return a.tick < b.tick; });
 }
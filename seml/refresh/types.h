@@ -1,10 +1,10 @@
 #pragma once
 
-#include <functional>
 #include <optional>
 #include <unordered_set>
 
-#include "../types.h"
+#include "seml/reader/types.h"
+#include "seml/types.h"
 #include "world.h"
 
 using ZombieTypes = std::unordered_set<pvz_emulator::object::zombie_type>;
@@ -28,10 +28,21 @@ struct LogRow {
     int curr_hp;
 };
 
+// One wave compiled by compile_wave. Refers to the config's actions, so the config must outlive
+// it.
+struct Program {
+    bool huge;
+    pvz_emulator::object::zombie_dance_cheat dance_cheat;
+    std::vector<ProgramOp> ops; // sorted by tick
+    std::vector<const Action*> actions;
+    size_t slot_num = 0;
+};
+
+// Reused across repeats by load_wave.
 struct Test {
     int init_hp;
+    ZombieList spawn_list;
     std::unordered_map<ZombieTypes, std::vector<float>, ZombieTypesHash> accident_rates;
     LogRow log;
-    std::vector<std::vector<unique_plant>> plants_to_be_shoveled;
-    std::vector<Op> ops;
+    std::vector<std::vector<unique_plant>> plants_to_be_shoveled; // by ProgramOp::slot
 };
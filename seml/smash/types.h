@@ -1,6 +1,5 @@
 #pragma once
 
-#include <functional>
 #include <sstream>
 #include <unordered_set>
 #include <variant>
@@ -30,10 +29,26 @@ struct ActionInfo {
     std::vector<unique_plant> plants;
 };
 
-struct Test {
+// All waves of a config compiled by compile_config. Refers to the config's actions, so the config
+// must outlive it.
+struct Program {
+    struct Spawn {
+        int tick;
+        int wave;
+        int giga_num;
+    };
+
     std::vector<Setting::ProtectPos> protect_positions;
+    std::vector<int> giga_rows;
+    std::vector<Spawn> spawns; // indexed by ProgramOp::action of Spawn ops
+    std::vector<ActionInfo> action_infos; // without plants; ProgramOp::slot indexes it
+    std::vector<ProgramOp> ops; // sorted by tick
+    std::vector<const Action*> actions;
+};
+
+// Reused across repeats by load_config.
+struct Test {
     std::vector<GigaInfo> giga_infos;
     std::vector<ActionInfo> action_infos;
-    std::vector<Op> ops;
     std::mt19937 rnd;
 };
@@ -1,12 +1,34 @@
 #pragma once
 
-#include <functional>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
 
 #include "world.h"
 
-struct Op {
+// One step of a compiled operation program. Programs are built once per config and replayed by
+// every repeat, which keeps its own mutable state (created plants etc.) in its Test.
+struct ProgramOp {
+    enum class Type : uint8_t {
+        Setup,
+        Spawn,
+        Ice,
+        Cob,
+        FixedCard,
+        SmartCard,
+        FixedFodder,
+        SmartFodderAll, // "C"
+        SmartFodderByGigaPos, // "C_POS"
+        SmartFodderByNum, // "C_NUM"
+        Shovel,
+    };
+
     int tick;
-    std::function<void(pvz_emulator::world&)> f;
+    Type type;
+    unsigned int action; // index into the program's actions; module-defined for Setup / Spawn
+    unsigned int position; // Cob: index into the cob's positions
+    int slot; // plant list of the repeat that the op appends to (or shovels), -1 if none
 };
 
 struct unique_plant {
@@ -21,4 +43,17 @@ struct unique_zombie {
     int uuid;
 
     bool is_valid() const { return ptr && ptr->uuid == uuid; }
-};
\ No newline at end of file
+};
+
+// Half-width of the 95% (normal) confidence interval of a mean, given the sum and the sum of
+// squares of its n samples. Infinite while n < 2.
+double get_ci_half_width(double sum, double square_sum, int n)
+{
+    if (n < 2) {
+        return std::numeric_limits<double>::infinity();
+    }
+
+    auto mean = sum / n;
+    auto variance = std::max(0.0, (square_sum - sum * mean) / (n - 1));
+    return 1.96 * std::sqrt(variance / n);
+}
@@ -2,19 +2,14 @@
  */
 
 #include "common/pe.h"
+#include "common/runner.h"
 #include "common/test.h"
 #include "seml/smash/lib.h"
 #include "world.h"
 
-#include <mutex>
-
 using namespace pvz_emulator;
 using namespace pvz_emulator::object;
 
-std::mutex mtx;
-
-TestInfo test_info;
-
 void validate_config(const Config& config)
 {
     if (config.waves.empty()) {
@@ -42,38 +37,65 @@ void validate_config(const Config& config)
     }
 }
 
-double calc_smash_rate(const Config& config, int smashed_garg_count, int total_garg_count)
+double calc_smash_rate(const Config& config, double smashed_garg_count, int total_garg_count)
 {
     int total_garg_rows = is_backyard(config.setting.scene_type) ? 4 : 5;
     return 100.0 * (smashed_garg_count / (total_garg_count / 5.0))
         * (static_cast<double>(config.setting.protect_positions.size()) / total_garg_rows);
 }
 
-void test_one(const Config& config, int repeat)
+const int CI_ROUND_SIZE = 1000;
+
+// Widest 95% confidence half-width of the reported smash rates (per wave and per row of ops),
+// taking each garg of a wave as one sample.
+double get_max_ci_half_width(const Config& config, const TestInfo& test_info)
 {
-    world w(config.setting.scene_type);
-    Test test;
-    TestInfo local_test_info;
-
-    for (int r = 0; r < repeat; r++) {
-        load_config(config, test);
-
-        w.scene.reset();
-        w.scene.stop_spawn = true;
-        w.scene.disable_garg_throw_imp = true;
-
-        auto prev_tick = test.ops.front().tick;
-        for (const auto& op : test.ops) {
-            run(w, op.tick - prev_tick);
-            op.f(w);
-            prev_tick = op.tick;
-        }
+    auto [table, summary] = test_info.make_table_and_summary();
 
-        local_test_info.update(test);
+    auto get_half_width = [&](int smashed_garg_count, int total_garg_count) {
+        auto half_width = get_ci_half_width(smashed_garg_count, smashed_garg_count, total_garg_count);
+        return calc_smash_rate(config, half_width * total_garg_count, total_garg_count);
+    };
+
+    double max_half_width = 0.0;
+    for (const auto& [wave, garg_summary] : summary.garg_summary_by_wave) {
+        max_half_width = std::max(max_half_width,
+            get_half_width(garg_summary.smashed_garg_count, garg_summary.total_garg_count));
+    }
+    for (const auto& [os, data] : table) {
+        max_half_width = std::max(max_half_width,
+            get_half_width(data.smashed_garg_count,
+                summary.garg_summary_by_wave.at(os.wave).total_garg_count));
     }
+    return max_half_width;
+}
+
+struct State {
+    world w;
+    Test test; // reused across repeats
+    TestInfo test_info;
+};
 
-    std::lock_guard<std::mutex> guard(mtx);
-    test_info.merge(local_test_info);
+void test_one(const Program& program, State& state, int repeat, uint64_t seed)
+{
+    auto& w = state.w;
+    auto& test = state.test;
+
+    w.scene.reset(derive_seed(seed, repeat));
+    load_config(program, test, static_cast<uint32_t>(w.scene.rng()));
+
+    w.scene.stop_spawn = true;
+    w.scene.disable_garg_throw_imp = true;
+    disable_idle_passes(w);
+
+    auto prev_tick = program.ops.front().tick;
+    for (const auto& op : program.ops) {
+        run(w, op.tick - prev_tick);
+        run_op(w, program, op, test);
+        prev_tick = op.tick;
+    }
+
+    state.test_info.update(test);
 }
 
 int main()
@@ -85,19 +107,33 @@ int main()
     auto args = parse_cmd_line();
     auto config_file = get_cmd_arg(args, "f");
     auto output_file = get_cmd_arg(args, "o", "smash_test");
-    auto total_repeat_num = std::stoi(get_cmd_arg(args, "r", "10000"));
+    auto ci_width = get_cmd_arg(args, "ci", ""); // with -ci, -r is the maximum
+    auto total_repeat_num = std::stoi(get_cmd_arg(args, "r", ci_width.empty() ? "10000" : "100000"));
+    auto seed = get_seed(args);
 
     auto [file, full_output_file] = open_csv(output_file);
 
     auto config = read_json(config_file);
     validate_config(config);
 
-    std::vector<std::thread> threads;
-    for (int repeat : assign_repeat(total_repeat_num, std::thread::hardware_concurrency())) {
-        threads.emplace_back([config, repeat]() { test_one(config, repeat); });
-    }
-    for (auto& t : threads) {
-        t.join();
+    auto program = compile_config(config);
+
+    auto make_state = [&]() { return State {world(config.setting.scene_type), {}, {}}; };
+    auto run_one = [&](State& state, int repeat) { test_one(program, state, repeat, seed); };
+    auto merge = [](State& into, State& from) { into.test_info.merge(from.test_info); };
+
+    TestInfo test_info;
+    if (ci_width.empty()) {
+        test_info = run_repeats(total_repeat_num, make_state, run_one, merge)->test_info;
+    } else {
+        // stop once every reported smash rate is known to within ±ci_width (in %)
+        auto max_half_width = std::stod(ci_width);
+        auto [state, repeat_num] = run_repeats_until(total_repeat_num, CI_ROUND_SIZE, make_state,
+            run_one, merge, [&](const State& state, int) {
+                return get_max_ci_half_width(config, state.test_info) <= max_half_width;
+            });
+        test_info = std::move(state->test_info);
+        total_repeat_num = repeat_num;
     }
 
     auto [table, summary] = test_info.make_table_and_summary();
@@ -136,12 +172,9 @@ int main()
         file << "\n";
     }
 
-    Test test;
-    load_config(config, test);
-
     file << "\n出生波数,单波砸率,砸炮数,总数,";
     auto prev_wave = -1;
-    for (const auto& action_info : test.action_infos) {
+    for (const auto& action_info : program.action_infos) {
         if (action_info.wave != prev_wave) {
             file << "[w" << action_info.wave << "] ";
             prev_wave = action_info.wave;
@@ -167,10 +200,16 @@ int main()
         file << "\n";
     }
 
+    if (!ci_width.empty()) {
+        file << "\n95%置信区间半宽," << std::fixed << std::setprecision(2)
+             << get_max_ci_half_width(config, test_info) << "%\n";
+        file << "重复次数," << total_repeat_num << "\n";
+    }
+
     std::chrono::duration<double> elapsed = std::chrono::high_resolution_clock::now() - start;
     std::cout << "输出文件已保存至 " << full_output_file << ".\n"
               << "耗时 " << std::fixed << std::setprecision(2) << elapsed.count() << " 秒, 使用了 "
-              << threads.size() << " 个线程." << std::endl;
+              << get_thread_num(total_repeat_num) << " 个线程, 随机种子 " << seed << "." << std::endl;
 
     return 0;
 }
\ No newline at end of file